@@ -0,0 +1,156 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Archive.hh"
+
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+
+#include "Event.hh"
+#include "Hash.hh"
+#include "Streams.hh"
+#include "TarReader.hh"
+#include "ThreadPool.hh"
+
+
+namespace n3 {
+	
+	namespace {
+		
+		ParseException inMember(const ParseException &e, const std::string &member)
+		{
+			return ParseException(std::string(e.what()) + " (in " + member + ")", e.line());
+		}
+		
+		std::uint64_t contentHash(const std::string &contents)
+		{
+			Hash64 hash;
+			hash.update(contents);
+			
+			return hash.value();
+		}
+		
+		struct Member {
+			std::string name;
+			std::string contents;
+			EventList events;
+			std::promise<void> done;
+			
+			Member(const std::string &name, std::string &&contents, bool streamsFormulas) : name(name), contents(std::move(contents)), events(streamsFormulas), done() {}
+		};
+	}
+	
+	void Archive::parse(std::istream &in, const std::string &uri)
+	{
+		if (m_jobs > 1)
+			parseParallel(in, uri);
+		else
+			parseSequential(in, uri);
+	}
+	
+	void Archive::parseSequential(std::istream &in, const std::string &uri)
+	{
+		TarReader tar(in);
+		MemoryStreamBuf buffer;
+		std::istream member(&buffer);
+		std::unique_ptr<Parser> parser;
+		
+		while (tar.next()) {
+			std::string contents = tar.contents();
+			Uri base(this->base(uri, tar.name()));
+			
+			buffer.reset(contents.data(), contents.size());
+			member.clear();
+			
+			if (parser) {
+				parser->reset(&member, base);
+			} else {
+				parser.reset(new Parser(&member, base, m_sink));
+				parser->typedValues(m_typedValues);
+				parser->streamFormulas(m_streamFormulas);
+			}
+			
+			if (m_deterministic)
+				parser->deterministic(contentHash(contents), name(uri, tar.name()));
+			
+			try {
+				parser->parse();
+			} catch (ParseException &e) {
+				throw inMember(e, tar.name());
+			}
+		}
+	}
+	
+	void Archive::parseParallel(std::istream &in, const std::string &uri)
+	{
+		TarReader tar(in);
+		std::deque<std::pair<std::shared_ptr<Member>, std::future<void>>> pending;
+		
+		auto replayFirst = [this, &pending] {
+			std::shared_ptr<Member> member = std::move(pending.front().first);
+			std::future<void> done = std::move(pending.front().second);
+			pending.pop_front();
+			
+			try {
+				done.get();
+			} catch (ParseException &e) {
+				throw inMember(e, member->name);
+			}
+			
+			member->events.replay(*m_sink);
+		};
+		
+		ThreadPool pool(m_jobs); // waits for the tasks when replayFirst() throws
+		
+		while (tar.next()) {
+			while (pending.size() >= 2 * m_jobs)
+				replayFirst();
+			
+			std::shared_ptr<Member> member = std::make_shared<Member>(tar.name(), tar.contents(), m_sink->streamsFormulas());
+			Uri base(this->base(uri, tar.name()));
+			std::string name(this->name(uri, tar.name()));
+			bool typedValues = m_typedValues, streamFormulas = m_streamFormulas, deterministic = m_deterministic;
+			
+			pending.emplace_back(member, member->done.get_future());
+			
+			pool.execute([member, base, name, typedValues, streamFormulas, deterministic] {
+				try {
+					MemoryStreamBuf buffer(member->contents.data(), member->contents.size());
+					std::istream in(&buffer);
+					
+					Parser parser(&in, base, &member->events);
+					parser.typedValues(typedValues);
+					parser.streamFormulas(streamFormulas);
+					if (deterministic)
+						parser.deterministic(contentHash(member->contents), name);
+					parser.parse();
+					
+					member->contents = std::string();
+					member->done.set_value();
+				} catch (...) {
+					member->done.set_exception(std::current_exception());
+				}
+			});
+		}
+		
+		while (!pending.empty())
+			replayFirst();
+	}
+
+}
@@ -0,0 +1,80 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_ARCHIVE_HH
+#define CARL_ARCHIVE_HH
+
+#include <istream>
+#include <string>
+
+#include "Optional.hh"
+#include "Parser.hh"
+
+namespace n3 {
+	
+	///
+	/// Translates the documents in a tar archive read from a stream, in one pass.
+	/// Every regular file is a document with its own scope, the base of member
+	/// "dir/a.n3" in the archive with uri "file:///x.tar" is "file:///x.tar/dir/a.n3".
+	///
+	/// With more than one job the members are parsed in parallel; the result is
+	/// the same, the sink receives the documents in archive order on the calling thread.
+	///
+	class Archive {
+		
+		TripleSink *m_sink;
+		unsigned m_jobs;
+		Optional<std::string> m_base;
+		bool m_typedValues;
+		bool m_streamFormulas;
+		bool m_deterministic;
+		
+		void parseSequential(std::istream &in, const std::string &uri);
+		void parseParallel(std::istream &in, const std::string &uri);
+		
+		std::string base(const std::string &uri, const std::string &member) const
+		{
+			return m_base ? *m_base : uri + "/" + member;
+		}
+		
+		/// The name for Parser::deterministic, telling apart members with the same base.
+		std::string name(const std::string &uri, const std::string &member) const
+		{
+			return m_base ? uri + "/" + member : std::string();
+		}
+		
+	public:
+		explicit Archive(TripleSink *sink, unsigned jobs = 1) : m_sink(sink), m_jobs(jobs), m_base(), m_typedValues(false), m_streamFormulas(false), m_deterministic(false) {}
+		
+		/// Uses base as the base of every member instead of the member uri.
+		void base(const std::string &base) { m_base = base; }
+		
+		/// See Parser::typedValues and Parser::streamFormulas.
+		void typedValues(bool typedValues) { m_typedValues = typedValues; }
+		void streamFormulas(bool streamFormulas) { m_streamFormulas = streamFormulas; }
+		
+		/// Derives the blank node ids of every member from its contents, see Parser::deterministic.
+		void deterministic(bool deterministic) { m_deterministic = deterministic; }
+		
+		/// Throws a ParseException naming the member for an invalid document,
+		/// or InputException for a damaged archive.
+		void parse(std::istream &in, const std::string &uri);
+	};
+
+}
+
+#endif /* CARL_ARCHIVE_HH */
@@ -0,0 +1,339 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Batch.hh"
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <cstdio>
+
+#include "Parser.hh"
+#include "CN3Writer.hh"
+#include "ThreadPool.hh"
+#include "Hash.hh"
+#include "Util.hh"
+#include "Memory.hh"
+#include "Version.hh"
+
+namespace n3 {
+	
+	Batch::Batch(const std::string &outdir, const Optional<std::string> &base, unsigned jobs, bool incremental)
+		: m_outdir(outdir), m_base(base), m_jobs(jobs), m_incremental(incremental), m_deterministic(false), m_manifest(), m_outputs(), m_results(), m_log()
+	{
+	}
+	
+	std::string Batch::outputName(const std::string &input)
+	{
+		std::size_t p = input.find_last_of("/\\");
+		std::string name = p == std::string::npos ? input : input.substr(p + 1);
+		
+		if (name.length() > 3 && name.compare(name.length() - 3, 3, ".n3") == 0)
+			return name + "p";
+		
+		return name + ".n3p";
+	}
+	
+	int Batch::run(const std::vector<std::string> &inputs, std::uint64_t &count)
+	{
+		count = 0;
+		
+		if (!n3::exists(m_outdir) && !n3::createDirectory(m_outdir)) {
+			std::cerr << "error creating directory \"" << m_outdir << "\"" << std::endl;
+			
+			return -1;
+		}
+		
+		std::string manifest = m_outdir + "/" + Manifest::FILE_NAME;
+		if (m_incremental && !m_manifest.load(manifest)) {
+			std::cerr << "ignoring corrupt manifest \"" << manifest << "\"" << std::endl;
+			m_manifest = Manifest();
+		}
+		
+		m_outputs.clear();
+		m_results.assign(inputs.size(), Result());
+		
+		std::set<std::string> names;
+		
+		for (std::size_t i = 0; i < inputs.size(); i++) {
+			const std::string &input = inputs[i];
+			
+			if (input == "-") {
+				std::cerr << "stdin can not be used as input for an output directory" << std::endl;
+				
+				return -1;
+			}
+			
+			if (!n3::exists(input)) {
+				std::cerr << "\"" << input << "\" not found" << std::endl;
+				
+				return -1;
+			}
+			
+			std::string name = outputName(input);
+			if (!names.insert(name).second) {
+				std::cerr << "more than one input is translated to \"" << name << "\"" << std::endl;
+				
+				return -1;
+			}
+			
+			m_outputs.push_back(m_outdir + "/" + name);
+			
+			Result &result = m_results[i];
+			result.ok = false;
+			result.translated = false;
+			result.changed = false;
+			
+			try {
+				result.entry.input = n3::toUri(input);
+			} catch (std::runtime_error &e) {
+				std::cerr << e.what() << std::endl;
+				
+				return -1;
+			}
+			
+			result.entry.base    = m_base ? *m_base : result.entry.input;
+			result.entry.version = m_deterministic ? CARL_VERSION_STR "+deterministic" : CARL_VERSION_STR; // the blank node ids differ
+		}
+		
+		if (m_jobs > 1 && inputs.size() > 1) {
+			ThreadPool pool(m_jobs);
+			
+			for (std::size_t i = 0; i < inputs.size(); i++)
+				pool.execute([this, &inputs, i] { translate(inputs[i], m_outputs[i], m_results[i]); });
+		} else {
+			for (std::size_t i = 0; i < inputs.size(); i++)
+				translate(inputs[i], m_outputs[i], m_results[i]);
+		}
+		
+		int status = 0;
+		unsigned translated = 0;
+		
+		for (const Result &result : m_results) {
+			if (result.ok) {
+				count += result.entry.count;
+				if (result.translated)
+					++translated;
+				if (m_incremental && result.changed)
+					m_manifest.remove(result.entry.input);
+				else if (m_incremental)
+					m_manifest.put(result.entry);
+			} else
+				status = -1;
+		}
+		
+		if (m_incremental) {
+			if (!m_manifest.save(manifest)) {
+				std::cerr << "error writing \"" << manifest << "\"" << std::endl;
+				
+				status = -1;
+			}
+			
+			std::cerr << "translated " << translated << " of " << inputs.size() << " inputs" << std::endl;
+		}
+		
+		return status;
+	}
+	
+	bool Batch::upToDate(const std::string &input, const std::string &output, Result &result)
+	{
+		Manifest::Entry &e = result.entry;
+		
+		if (!n3::fileStatus(input, e.size, e.mtime))
+			return false;
+		
+		const Manifest::Entry *previous = m_manifest.find(e.input);
+		if (!previous || previous->base != e.base || previous->version != e.version || previous->size != e.size)
+			return false;
+		
+		std::uint64_t length;
+		std::int64_t mtime;
+		if (!n3::fileStatus(output, length, mtime) || length != previous->length)
+			return false;
+		
+		if (previous->mtime != e.mtime) {
+			// touched, compare the contents; e keeps the new mtime, so the manifest records it
+			// and the next run does not hash the input again
+			if (!Hash64::file(input, e.hash) || e.hash != previous->hash)
+				return false;
+		}
+		
+		e.hash   = previous->hash;
+		e.count  = previous->count;
+		e.begin  = previous->begin;
+		e.end    = previous->end;
+		e.length = previous->length;
+		
+		return true;
+	}
+	
+	void Batch::translate(const std::string &input, const std::string &output, Result &result)
+	{
+		try {
+			translateFile(input, output, result);
+		} catch (std::bad_alloc &e) {
+			Memory::Unlimited unlimited;
+			
+			result.ok = false;
+			std::remove(output.c_str());
+			
+			std::lock_guard<std::mutex> lock(m_log);
+			if (dynamic_cast<MemoryLimitExceeded *>(&e))
+				std::cerr << input << ": memory limit of " << Memory::limit() << " bytes exceeded" << std::endl;
+			else
+				std::cerr << input << ": out of memory" << std::endl;
+		}
+	}
+	
+	void Batch::translateFile(const std::string &input, const std::string &output, Result &result)
+	{
+		if (m_incremental && upToDate(input, output, result)) {
+			result.ok = true;
+			
+			return;
+		}
+		
+		Manifest::Entry &e = result.entry;
+		
+		// the status is taken before the input is read, so a change during the translation is noticed
+		if (m_incremental && !n3::fileStatus(input, e.size, e.mtime)) {
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "error reading \"" << input << "\"" << std::endl;
+			
+			return;
+		}
+		
+		if ((m_incremental || m_deterministic) && !Hash64::file(input, e.hash)) {
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "error reading \"" << input << "\"" << std::endl;
+			
+			return;
+		}
+		
+		std::ifstream in(input, std::ios_base::in | std::ios_base::binary);
+		if (!in) {
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "error opening \"" << input << "\"" << std::endl;
+			
+			return;
+		}
+		
+		std::unique_ptr<char[]> buffer(new char[OUTPUT_BUFFER_SIZE]);
+		
+		std::ofstream out;
+		out.rdbuf()->pubsetbuf(buffer.get(), OUTPUT_BUFFER_SIZE);
+		out.open(output, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!out) {
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "error opening \"" << output << "\"" << std::endl;
+			
+			return;
+		}
+		
+		{
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "translating " << e.input << std::endl;
+		}
+		
+		CN3Writer writer(out);
+		Parser parser(&in, Uri(e.base), &writer);
+		if (m_deterministic)
+			parser.deterministic(e.hash, m_base ? e.input : std::string());
+		
+		try {
+			writer.start();
+			e.begin = out.tellp();
+			parser.parse();
+			e.end = out.tellp();
+			writer.end();
+			e.length = out.tellp();
+		} catch (ParseException &ex) {
+			out.close();
+			std::remove(output.c_str());
+			
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << input << ": " << ex.report() << std::endl;
+			
+			return;
+		}
+		
+		out.close();
+		if (!out) {
+			std::lock_guard<std::mutex> lock(m_log);
+			std::cerr << "error writing \"" << output << "\"" << std::endl;
+			
+			return;
+		}
+		
+		e.count = writer.count();
+		
+		if (m_incremental) {
+			std::uint64_t size;
+			std::int64_t mtime;
+			if (!n3::fileStatus(input, size, mtime) || size != e.size || mtime != e.mtime) {
+				result.changed = true;
+				
+				std::lock_guard<std::mutex> lock(m_log);
+				std::cerr << "\"" << input << "\" changed while it was translated, it is translated again on the next run" << std::endl;
+			}
+		}
+		
+		result.ok = true;
+		result.translated = true;
+	}
+	
+	bool Batch::combine(std::ostream &out)
+	{
+		const std::size_t BUFFER_SIZE = 64 * 1024;
+		std::unique_ptr<char[]> buffer(new char[BUFFER_SIZE]);
+		
+		CN3Writer writer(out);
+		writer.start();
+		
+		for (std::size_t i = 0; i < m_results.size(); i++) {
+			const Manifest::Entry &e = m_results[i].entry;
+			
+			std::ifstream in(m_outputs[i], std::ios_base::in | std::ios_base::binary);
+			if (!in.seekg(e.begin)) {
+				std::cerr << "error reading \"" << m_outputs[i] << "\"" << std::endl;
+				
+				return false;
+			}
+			
+			std::uint64_t remaining = e.end - e.begin;
+			while (remaining > 0) {
+				std::streamsize n = remaining < BUFFER_SIZE ? remaining : BUFFER_SIZE;
+				if (!in.read(buffer.get(), n)) {
+					std::cerr << "error reading \"" << m_outputs[i] << "\"" << std::endl;
+					
+					return false;
+				}
+				
+				writer.append(buffer.get(), n);
+				remaining -= n;
+			}
+			
+			writer.addCount(e.count);
+		}
+		
+		writer.end();
+		
+		return static_cast<bool>(out);
+	}
+
+}
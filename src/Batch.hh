@@ -0,0 +1,83 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_BATCH_HH
+#define CARL_BATCH_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "Optional.hh"
+#include "Manifest.hh"
+
+namespace n3 {
+	
+	///
+	/// Translates every input to its own N3P file in an output directory,
+	/// optionally translating several inputs in parallel.
+	///
+	/// In incremental mode a manifest in the output directory records the state of every input,
+	/// inputs whose output is still up to date are not translated again.
+	///
+	class Batch {
+		
+		struct Result {
+			bool ok;
+			bool translated;
+			bool changed; // the input changed while it was translated, the entry is not recorded
+			Manifest::Entry entry;
+		};
+		
+		std::string m_outdir;
+		Optional<std::string> m_base;
+		unsigned m_jobs;
+		bool m_incremental;
+		bool m_deterministic;
+		
+		Manifest m_manifest;
+		std::vector<std::string> m_outputs;
+		std::vector<Result> m_results;
+		
+		std::mutex m_log;
+		
+		bool upToDate(const std::string &input, const std::string &output, Result &result);
+		/// Translates one input, reporting its errors, including running out of memory.
+		void translate(const std::string &input, const std::string &output, Result &result);
+		void translateFile(const std::string &input, const std::string &output, Result &result);
+		
+	public:
+		Batch(const std::string &outdir, const Optional<std::string> &base, unsigned jobs, bool incremental);
+		
+		/// Derives the blank node ids of every output from its input, see Parser::deterministic.
+		void deterministic(bool deterministic) { m_deterministic = deterministic; }
+		
+		/// Returns the exit status for the process, count is set to the total number of triples.
+		int run(const std::vector<std::string> &inputs, std::uint64_t &count);
+		
+		/// Concatenates the outputs of the last run in one N3P document.
+		/// The bodies of the outputs are copied, no input is translated again.
+		bool combine(std::ostream &out);
+		
+		/// The name of the output file for an input file: "dir/name.n3" becomes "name.n3p".
+		static std::string outputName(const std::string &input);
+	};
+
+}
+
+#endif /* CARL_BATCH_HH */
@@ -0,0 +1,149 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "BinaryWriter.hh"
+
+#include <cstring>
+
+
+namespace n3 {
+	
+	const char BinaryWriter::MAGIC[8] = { 'c', 'a', 'r', 'l', 'b', 'i', 'n', '\0' };
+	
+	void BinaryWriter::start()
+	{
+		m_outbuf->sputn(MAGIC, sizeof(MAGIC));
+		m_outbuf->sputc(static_cast<char>(VERSION));
+	}
+	
+	void BinaryWriter::end()
+	{
+		m_outbuf->sputc('E');
+		writeVarint(m_count);
+		m_outbuf->pubsync();
+	}
+	
+	void BinaryWriter::writeIri(const std::string &iri)
+	{
+		auto i = m_iris.find(iri);
+		if (i != m_iris.end()) {
+			m_outbuf->sputc(IRI_REF);
+			writeVarint(i->second);
+		} else {
+			m_iris.emplace(iri, m_iris.size());
+			m_outbuf->sputc(IRI);
+			writeString(iri);
+		}
+	}
+	
+	void BinaryWriter::visit(const URIResource &resource)
+	{
+		writeIri(resource.uri());
+	}
+	
+	void BinaryWriter::visit(const BlankNode &blankNode)
+	{
+		m_outbuf->sputc(BLANK);
+		writeString(blankNode.id());
+	}
+	
+	void BinaryWriter::visit(const Literal &literal)
+	{
+		m_outbuf->sputc(TYPED);
+		writeIri(literal.datatype());
+		writeString(literal.lexical());
+	}
+	
+	void BinaryWriter::visit(const BooleanLiteral &literal)
+	{
+		m_outbuf->sputc(BOOLEAN);
+		m_outbuf->sputc(literal.value() ? 1 : 0);
+	}
+	
+	void BinaryWriter::visit(const IntegerLiteral &literal)
+	{
+		if (literal.hasValue()) {
+			m_outbuf->sputc(INT64);
+			writeSigned(literal.value());
+		} else {
+			m_outbuf->sputc(INTEGER);
+			writeString(literal.lexical());
+		}
+	}
+	
+	void BinaryWriter::visit(const DoubleLiteral &literal)
+	{
+		if (literal.hasValue()) {
+			double value = literal.value();
+			std::uint64_t bits;
+			std::memcpy(&bits, &value, sizeof bits);
+			
+			m_outbuf->sputc(FLOAT64);
+			for (int i = 0; i < 8; i++, bits >>= 8)
+				m_outbuf->sputc(static_cast<char>(bits & 0xFF));
+		} else {
+			m_outbuf->sputc(DOUBLE);
+			writeString(literal.lexical());
+		}
+	}
+	
+	void BinaryWriter::visit(const DecimalLiteral &literal)
+	{
+		if (literal.hasValue()) {
+			m_outbuf->sputc(DECIMAL64);
+			writeSigned(literal.unscaled());
+			writeVarint(literal.scale());
+		} else {
+			m_outbuf->sputc(DECIMAL);
+			writeString(literal.lexical());
+		}
+	}
+	
+	void BinaryWriter::visit(const StringLiteral &literal)
+	{
+		m_outbuf->sputc(STRING);
+		writeString(literal.lexical());
+		writeString(literal.language());
+	}
+	
+	void BinaryWriter::visit(const RDFList &list)
+	{
+		m_outbuf->sputc(LIST);
+		writeVarint(list.size());
+		for (const N3Node *n : list)
+			n->visit(*this);
+	}
+	
+	void BinaryWriter::visit(const GraphTemplate &graph)
+	{
+		m_outbuf->sputc(GRAPH);
+		writeString(graph.id());
+		writeVarint(graph.size());
+		for (const TriplePattern &t : graph) {
+			t.subject().visit(*this);
+			t.property().visit(*this);
+			t.object().visit(*this);
+		}
+	}
+	
+	void BinaryWriter::visit(const Var &var)
+	{
+		m_outbuf->sputc(VAR);
+		writeString(var.name());
+	}
+
+}
@@ -0,0 +1,142 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_BINARY_WRITER_HH
+#define CARL_BINARY_WRITER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "Parser.hh"
+
+namespace n3 {
+	
+	///
+	/// Writes a compact binary serialization.
+	///
+	/// The output starts with the 8 byte magic "carlbin\0" followed by a version byte,
+	/// followed by records, every record starting with a tag byte:
+	///
+	///     'D' string                  document
+	///     'P' string string           prefix
+	///     'T' term term term          triple
+	///     'E' varint                  end, the number of triples
+	///
+	/// Every term starts with a tag byte (see Tag). IRIs are dictionary coded:
+	/// the first occurrence of an IRI is written in full and gets the next number,
+	/// later occurrences only write that number.
+	/// Integers are LEB128 varints, strings are a varint length followed by UTF-8 bytes.
+	/// Literals parsed with typed values are written as native values (INT64, FLOAT64, DECIMAL64),
+	/// otherwise, or when the value does not fit, as their lexical form.
+	///
+	class BinaryWriter : public DefaultTripleSink, private N3NodeVisitor {
+		
+		std::streambuf *m_outbuf;
+		std::unordered_map<std::string, std::uint64_t> m_iris;
+		
+		void writeVarint(std::uint64_t n)
+		{
+			while (n >= 0x80) {
+				m_outbuf->sputc(static_cast<char>((n & 0x7F) | 0x80));
+				n >>= 7;
+			}
+			m_outbuf->sputc(static_cast<char>(n));
+		}
+		
+		void writeSigned(std::int64_t n)
+		{
+			writeVarint((static_cast<std::uint64_t>(n) << 1) ^ static_cast<std::uint64_t>(n >> 63));
+		}
+		
+		void writeString(const std::string &s)
+		{
+			writeVarint(s.length());
+			m_outbuf->sputn(s.data(), s.length());
+		}
+		
+		void writeIri(const std::string &iri);
+		
+		void visit(const URIResource &resource) override;
+		void visit(const BlankNode &blankNode) override;
+		void visit(const Literal &literal) override;
+		void visit(const BooleanLiteral &literal) override;
+		void visit(const IntegerLiteral &literal) override;
+		void visit(const DoubleLiteral &literal) override;
+		void visit(const DecimalLiteral &literal) override;
+		void visit(const StringLiteral &literal) override;
+		void visit(const RDFList &list) override;
+		void visit(const GraphTemplate &graph) override;
+		void visit(const Var &var) override;
+		
+	public:
+		
+		static const char MAGIC[8];
+		static const std::uint8_t VERSION = 2;
+		
+		enum Tag : std::uint8_t {
+			IRI          = 0x01, // string, defines the next IRI number
+			IRI_REF      = 0x02, // varint, a previously defined IRI
+			BLANK        = 0x03, // string id
+			STRING       = 0x04, // string lexical, string language (empty when none)
+			TYPED        = 0x05, // IRI term datatype, string lexical
+			BOOLEAN      = 0x06, // byte 0 or 1
+			INTEGER      = 0x07, // string lexical
+			DOUBLE       = 0x08, // string lexical
+			DECIMAL      = 0x09, // string lexical
+			LIST         = 0x0A, // varint size, terms
+			GRAPH        = 0x0B, // string id, varint size, triples (three terms each)
+			VAR          = 0x0C, // string name
+			INT64        = 0x0D, // zigzag varint, a parsed xsd:integer
+			FLOAT64      = 0x0E, // 8 bytes IEEE 754 little endian, a parsed xsd:double
+			DECIMAL64    = 0x0F  // zigzag varint unscaled, varint scale, a parsed xsd:decimal
+		};
+		
+		explicit BinaryWriter(std::ostream &out) : DefaultTripleSink(), N3NodeVisitor(), m_outbuf(out.rdbuf()), m_iris() {}
+		
+		void start() override;
+		void end() override;
+		
+		void document(const std::string &source) override
+		{
+			m_outbuf->sputc('D');
+			writeString(source);
+		}
+		
+		void prefix(const std::string &prefix, const std::string &ns) override
+		{
+			m_outbuf->sputc('P');
+			writeString(prefix);
+			writeString(ns);
+		}
+		
+		void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override
+		{
+			m_outbuf->sputc('T');
+			subject.visit(*this);
+			property.visit(*this);
+			object.visit(*this);
+			
+			++m_count;
+		}
+	};
+
+}
+
+#endif /* CARL_BINARY_WRITER_HH */
@@ -16,30 +16,30 @@
 
 #include "BlankNodeIdGenerator.hh"
 
-#include <random>
 #include <chrono>
 #include <cstdint>
 
 namespace n3 {
 	
-	void BlankNodeIdGenerator::initialize()
+	void BlankNodeIdGenerator::seed()
 	{
 		typedef std::chrono::high_resolution_clock Clock;
 		
-		std::default_random_engine generator;
-		
-		constexpr int max = 'Z' - 'A' + '9' - '0' - 1; 
-		std::uniform_int_distribution<int> distribution(0, max);
-		
 		Clock::time_point t = Clock::now();
 		Clock::duration d = t.time_since_epoch();
-		generator.seed(d.count() + reinterpret_cast<std::uintptr_t>(this));
+		m_generator.seed(d.count() + reinterpret_cast<std::uintptr_t>(this));
+	}
+	
+	void BlankNodeIdGenerator::initialize()
+	{
+		constexpr int max = 'Z' - 'A' + '9' - '0' - 1; 
+		std::uniform_int_distribution<int> distribution(0, max);
 		
 		m_prefix.clear();
 		m_prefix.reserve(m_length);
 		
 		for (std::size_t i = 0; i < m_length; i++) {
-			int n = distribution(generator);  // generates number in the range 0..35
+			int n = distribution(m_generator);  // generates number in the range 0..35
 		
 			if (n < 10)
 				m_prefix.push_back(n + '0');
@@ -49,5 +49,18 @@ namespace n3 {
 		
 		m_c = 0;
 	}
+	
+	void BlankNodeIdGenerator::initialize(std::uint64_t hash)
+	{
+		m_prefix.assign(m_length, '0');
+		
+		for (std::size_t i = m_length; i > 0 && hash; i--, hash /= 36) {
+			int n = static_cast<int>(hash % 36);
+			
+			m_prefix[i - 1] = n < 10 ? n + '0' : n - 10 + 'A';
+		}
+		
+		m_c = 0;
+	}
 
 }
@@ -18,7 +18,9 @@
 #define CARL_BLANKNODEIDGENERATOR_HH
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <random>
 
 namespace n3 {
 	
@@ -26,13 +28,15 @@ namespace n3 {
 		
 		static const std::size_t m_length = 16;
 		
+		std::default_random_engine m_generator;
 		std::string m_prefix;
-		unsigned m_c;
+		std::uint64_t m_c;
 		
 	public:
 		
-		BlankNodeIdGenerator() : m_prefix(), m_c(0)
+		BlankNodeIdGenerator() : m_generator(), m_prefix(), m_c(0)
 		{
+			seed();
 			initialize();
 		}
 		
@@ -46,7 +50,17 @@ namespace n3 {
 			return m_prefix + "-" + id;
 		}
 		
+		/// Starts a new document: draws a new prefix and restarts the counter.
 		void initialize();
+		
+		/// Starts a new document with a prefix derived from hash instead of a random one,
+		/// so the same hash gives the same ids.
+		void initialize(std::uint64_t hash);
+		
+		void seed();
+		
+		/// Makes next the number of the next generated id, for tests of ids past 2^32.
+		void next(std::uint64_t next) { m_c = next; }
 	};
 
 }
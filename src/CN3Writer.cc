@@ -26,18 +26,53 @@ namespace n3 {
 	
 	void N3PFormatter::visit(const URIResource &resource)
 	{
-		m_outbuf->sputc('\'');
-		m_outbuf->sputc('<');
-		outputUri(resource.uri());
-		m_outbuf->sputc('>');
-		m_outbuf->sputc('\'');
+		const std::string &uri = resource.uri();
+		
+		CachedUri &cached = m_uris[slot(uri)];
+		if (cached.uri == uri) {
+			++m_hits;
+			m_outbuf->sputn(cached.term.c_str(), cached.term.length());
+			
+			return;
+		}
+		
+		++m_misses;
+		
+		cached.uri = uri;
+		
+#ifndef CARL_N3P_CESU8
+		if (uri.find('\'') == std::string::npos) {
+			cached.term.assign("'<", 2);
+			cached.term.append(uri);
+			cached.term.append(">'", 2);
+		} else
+#endif /* CARL_N3P_CESU8 */
+		{
+			// format the term with outputUri, in m_term
+			std::streambuf *outbuf = m_outbuf;
+			m_outbuf = &m_term;
+			m_term.clear();
+			
+			m_outbuf->sputc('\'');
+			m_outbuf->sputc('<');
+			outputUri(uri);
+			m_outbuf->sputc('>');
+			m_outbuf->sputc('\'');
+			
+			m_outbuf = outbuf;
+			
+			cached.term = m_term.str();
+		}
+		
+		m_outbuf->sputn(cached.term.c_str(), cached.term.length());
 	}
 	
 	void N3PFormatter::visit(const BlankNode &blankNode)
 	{
 		const std::string &id = blankNode.id();
 		
-		if (!rule()) {
+		// a blank node outside the formulas of a rule, like the object of {...} => {...}!:p, is not a variable
+		if (!rule() || m_graphs.empty()) {
 			m_outbuf->sputc('\'');
 			m_outbuf->sputc('<');
 			m_outbuf->sputn(SKOLEM_PREFIX.c_str(), SKOLEM_PREFIX.length());
@@ -85,90 +120,20 @@ namespace n3 {
 	
 	void N3PFormatter::visit(const IntegerLiteral &literal)
 	{
-		const std::string &lexical = literal.lexical();
-		
-		m_outbuf->sputn(lexical.c_str(), lexical.length());
+		m_numbers.writeInteger(m_outbuf, literal.lexical());
 	}
 	
 	void N3PFormatter::visit(const DoubleLiteral &literal)
 	{
-		const std::string &value = literal.lexical();
-		
-		// values like .5 and -.5 are not allowed in prolog
-		// values like 5. and 5.E0 are not allowed in prolog
-		
-		bool appendZero = false;
-		
-		std::string s;
-		const std::string *sp = &value;
-		
-		std::size_t p = value.find('.');
-		if (p != std::string::npos) {
-			++p;
-			if (p == value.length()) {
-				appendZero = true;
-			} else if (value[p] == 'E' || value[p] == 'e') {
-				s.reserve(value.length() + 1);
-				s = value;
-				s.insert(p, 1, '0');
-				sp = &s;
-			}
-		}
-		
-		if ((*sp)[0] == '.') {
-			m_outbuf->sputc('0');
-			m_outbuf->sputn(sp->c_str(), sp->length());
-			if (appendZero)
-				m_outbuf->sputc('0');
-		} else if ((*sp)[0] == '-' && (*sp)[1] == '.') {
-			m_outbuf->sputc('-');
-			m_outbuf->sputc('0');
-			m_outbuf->sputn(sp->c_str() + 1, sp->length() - 1);
-			if (appendZero)
-				m_outbuf->sputc('0');
-		} else {
-			m_outbuf->sputn(sp->c_str(), sp->length());
-			if (appendZero)
-				m_outbuf->sputc('0');
-		}
+		m_numbers.writeDouble(m_outbuf, literal.lexical());
 	}
 	
 	void N3PFormatter::visit(const DecimalLiteral &literal)
 	{
-		const std::string &value = literal.lexical();
-		
-		if (m_rdivDecimal) {
-			std::size_t p = value.find('.');
-			if (p == std::string::npos) {
-				m_outbuf->sputn(value.c_str(), value.length());
-				m_outbuf->sputn(" rdiv 1", 7);
-			} else {
-				m_outbuf->sputn(value.c_str(), p++);
-				std::size_t len = value.length() - p;
-				m_outbuf->sputn(value.c_str() + p, len);
-				m_outbuf->sputn(" rdiv 1", 7);
-				for (std::size_t i = 0; i < len; i++)
-					m_outbuf->sputc('0');
-			}
-		} else {
-			// values like .5 and -.5 are not allowed in prolog
-			// values like 5. are not allowed in prolog
-			
-			if (value[0] == '.') {
-				m_outbuf->sputc('0');
-				m_outbuf->sputn(value.c_str(), value.length());
-			} else if (value[0] == '-' && value[1] == '.') {
-				m_outbuf->sputc('-');
-				m_outbuf->sputc('0');
-				m_outbuf->sputn(value.c_str() + 1, value.length() - 1);
-			} else {
-				m_outbuf->sputn(value.c_str(), value.length());
-			}
-			
-			std::size_t length = value.length();
-			if (length > 0 && value[length - 1] == '.')
-				m_outbuf->sputc('0');
-		}
+		if (m_rdivDecimal)
+			m_numbers.writeRational(m_outbuf, literal.lexical());
+		else
+			m_numbers.writeDecimal(m_outbuf, literal.lexical());
 	}
 
 	void N3PFormatter::visit(const StringLiteral &literal)
@@ -253,6 +218,59 @@ namespace n3 {
 			rule(false);
 	}
 	
+	void N3PFormatter::begin(const GraphTemplate &graph, bool wrap)
+	{
+		m_graphs.push_back(graph.id());
+		
+		m_streamed = &graph;
+		m_streamedWrap = wrap;
+		m_streamedCount = 0;
+	}
+	
+	void N3PFormatter::triple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		// like output(graph, wrap), which needs the number of triples: the first triple is held back
+		switch (m_streamedCount++) {
+			case 0:
+				m_held.push_back(TriplePattern(subject, property, object));
+				return;
+			case 1: {
+				const TriplePattern &t = m_held.front();
+				if (m_streamedWrap)
+					m_outbuf->sputc('(');
+				m_writer.outputTriple(t.subject(), t.property(), t.object(), m_streamed);
+				m_held.clear();
+			}
+			/* fall through */
+			default:
+				m_outbuf->sputc(',');
+				m_outbuf->sputc(' ');
+				m_writer.outputTriple(subject, property, object, m_streamed);
+		}
+	}
+	
+	void N3PFormatter::end()
+	{
+		switch (m_streamedCount) {
+			case 0: m_outbuf->sputn("true", 4); break;
+			case 1: {
+				const TriplePattern &t = m_held.front();
+				m_writer.outputTriple(t.subject(), t.property(), t.object(), m_streamed);
+				m_held.clear();
+				break;
+			}
+			default:
+				if (m_streamedWrap)
+					m_outbuf->sputc(')');
+		}
+		
+		m_streamed = nullptr;
+		
+		m_graphs.pop_back();
+		if (m_graphs.empty())
+			rule(false);
+	}
+	
 	void N3PFormatter::visit(const Var &var)
 	{
 		const std::string &name = var.name();
@@ -346,10 +364,9 @@ namespace n3 {
 //	}
 	
 	
-	void CN3Writer::outputTriple(const N3Node &subject, const URIResource &property, const N3Node &object, const GraphTemplate *graph)
+	CN3Writer::Statement CN3Writer::outputHead(const N3Node &subject, const URIResource &property, const GraphTemplate *graph)
 	{
-		bool implies = false;
-		bool backwardsImplies = false;
+		Statement statement = Statement();
 		
 		if (property.uri() == LOG::implies.uri()) {
 			m_formatter.rule(true);
@@ -357,7 +374,7 @@ namespace n3 {
 				m_formatter.visit(LOG::implies);
 			} else {
 				m_out.write("implies", 7);
-				implies = true;
+				statement.implies = true;
 			}
 			m_out.put('(');
 		} else if (property.uri() == LOG::reverseImplies.uri()) {
@@ -385,42 +402,69 @@ namespace n3 {
 				m_out.put(' ');
 			}
 			m_out.write(":- ", 3);
-			backwardsImplies = true;
+			statement.backwardsImplies = true;
 		} else {
 			m_formatter.visit(property);
 			m_out.put('(');
 		}
 		
-		if (!backwardsImplies) {
+		if (!statement.backwardsImplies) {
 			subject.visit(m_formatter);
 			m_out.put(',').put(' ');
-			if (implies)
+			if (statement.implies)
 				m_formatter.rule(true);
-			object.visit(m_formatter);
 		} else {
 			m_formatter.rule(true);
-			if (!object.isGraphTemplate())
-				object.visit(m_formatter);
-			else
-				m_formatter.output(static_cast<const GraphTemplate &>(object), false);
-			
-			if (graph) {
-				m_out.put(')');
-			}
 		}
+		
+		return statement;
+	}
+	
+	void CN3Writer::outputTail(const Statement &statement, const GraphTemplate *graph)
+	{
+		if (statement.backwardsImplies && graph)
+			m_out.put(')');
 
-		if (implies) {
+		if (statement.implies) {
 			m_out.write(", '<", 4);
 			m_formatter.outputUri(m_source);
 			m_out.write(">'", 2);
 		}
 		
-		if (!backwardsImplies)
+		if (!statement.backwardsImplies)
 			m_out.put(')');
 		
 		++m_count;
 	}
 	
+	void CN3Writer::outputTriple(const N3Node &subject, const URIResource &property, const N3Node &object, const GraphTemplate *graph)
+	{
+		Statement statement = outputHead(subject, property, graph);
+		
+		if (statement.backwardsImplies && object.isGraphTemplate())
+			m_formatter.output(static_cast<const GraphTemplate &>(object), false);
+		else
+			object.visit(m_formatter);
+		
+		outputTail(statement, graph);
+	}
+	
+	void CN3Writer::beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula)
+	{
+		// the parser only streams formulas with log:implies or log:reverseImplies as property
+		m_formula = outputHead(subject, static_cast<const URIResource &>(property), nullptr);
+		m_formatter.begin(formula, !m_formula.backwardsImplies);
+	}
+	
+	void CN3Writer::endFormula()
+	{
+		m_formatter.end();
+		outputTail(m_formula, nullptr);
+		
+		m_out.put('.');
+		endl();
+	}
+	
 	void CN3Writer::outputTriple(const N3Node &subject, const N3Node &property, const N3Node &object, const GraphTemplate *graph)
 	{
 		if (property.isURIResource()) {
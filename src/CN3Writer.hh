@@ -14,13 +14,19 @@
 // limitations under the License.
 //
 
+#ifndef CARL_CN3WRITER_HH
+#define CARL_CN3WRITER_HH
+
 #include <ostream>
 #include <string>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 
 #include "Parser.hh"
+#include "Streams.hh"
+#include "NumberFormat.hh"
 #include "Utf8.hh"
 #include "Utf16.hh"
 
@@ -41,16 +47,33 @@ namespace n3 {
 		std::streambuf *m_outbuf;
 		
 		bool m_rdivDecimal; // output decimals as rdivs
+		NumberFormat m_numbers;
 		
 		std::vector<std::string> m_graphs;
 		
 		bool m_rule;
 		
+		const GraphTemplate *m_streamed; // the formula being streamed, see begin()
+		bool m_streamedWrap;
+		std::size_t m_streamedCount;
+		std::vector<TriplePattern> m_held;
+		
+		struct CachedUri {
+			std::string uri;
+			std::string term; // the N3P term '<uri>'
+		};
+		
+		std::vector<CachedUri> m_uris; // direct mapped, a uri can only be in slot(uri)
+		StringStreamBuf m_term;
+		unsigned long m_hits;
+		unsigned long m_misses;
+		
 	public:
 		static const std::string SKOLEM_PREFIX;
 		static const char HEX_CHAR[];
+		static const std::size_t URI_CACHE_SIZE = 4096; // a power of two
 		
-		N3PFormatter(CN3Writer &writer, std::ostream &out, bool rdivDecimal) : N3NodeVisitor(), m_writer(writer), m_outbuf(out.rdbuf()), m_rdivDecimal(rdivDecimal), m_graphs(), m_rule()
+		N3PFormatter(CN3Writer &writer, std::ostream &out, bool rdivDecimal) : N3NodeVisitor(), m_writer(writer), m_outbuf(out.rdbuf()), m_rdivDecimal(rdivDecimal), m_numbers(), m_graphs(), m_rule(), m_streamed(nullptr), m_streamedWrap(false), m_streamedCount(0), m_held(), m_uris(URI_CACHE_SIZE), m_term(), m_hits(0), m_misses(0)
 		{
 			// nop
 		}
@@ -67,11 +90,42 @@ namespace n3 {
 		void visit(const GraphTemplate &graph) override;
 		void visit(const Var &var) override;
 		
+		void reset()
+		{
+			m_graphs.clear();
+			m_rule = false;
+			m_streamed = nullptr;
+			m_held.clear();
+		}
+		
+		/// The cache slot of a uri. Uris often only differ at the end, so only the last bytes are hashed.
+		static std::size_t slot(const std::string &uri)
+		{
+			std::size_t h = uri.length();
+			std::size_t n = h < 16 ? h : 16;
+			
+			for (const char *p = uri.data() + h - n; n > 0; --n, ++p)
+				h = h * 31 + static_cast<unsigned char>(*p);
+			
+			return h & (URI_CACHE_SIZE - 1);
+		}
+		
+		NumberFormat &numbers() { return m_numbers; }
+		
+		unsigned long hits() const { return m_hits; }
+		unsigned long misses() const { return m_misses; }
+		
 		void rule(bool rule) { m_rule = rule; }
 		bool rule() const { return m_rule; }
 		
 		void output(const GraphTemplate &graph, bool wrap);
 		
+		/// Outputs a formula triple by triple: begin(graph, wrap), triple() for every triple
+		/// and end() write the same as output(graph, wrap) with graph holding the triples.
+		void begin(const GraphTemplate &graph, bool wrap);
+		void triple(const N3Node &subject, const N3Node &property, const N3Node &object);
+		void end();
+		
 		void output(const std::string &s)
 		{
 			for (auto i = s.cbegin(); i != s.cend(); ++i) {
@@ -184,6 +238,17 @@ namespace n3 {
 		N3PFormatter m_formatter;
 		std::string m_source;
 //		std::unordered_set<std::string> m_properties;
+		
+		struct Statement {
+			bool implies;          // a top-level log:implies, written as implies/3
+			bool backwardsImplies; // log:reverseImplies, written as a clause
+		};
+		
+		Statement m_formula; // the statement of the formula being streamed
+		
+		/// Writes a statement up to its object, outputTail() writes the rest.
+		Statement outputHead(const N3Node &subject, const URIResource &property, const GraphTemplate *graph);
+		void outputTail(const Statement &statement, const GraphTemplate *graph);
 
 //		void outputProperty(const std::string &uri);
 		
@@ -208,7 +273,7 @@ namespace n3 {
 		
 	public:
 		
-		CN3Writer(std::ostream &out) : DefaultTripleSink(), m_out(out), m_formatter(*this, out, false), m_source()/*, m_properties()*/
+		CN3Writer(std::ostream &out) : DefaultTripleSink(), m_out(out), m_formatter(*this, out, false), m_source(), m_formula()/*, m_properties()*/
 		{
 			// nop
 		}
@@ -227,9 +292,57 @@ namespace n3 {
 		void outputTriple(const N3Node &subject, const N3Node &property, const N3Node &object, const GraphTemplate *graph = nullptr);
 		void outputTriple(const N3Node &subject, const URIResource &property, const N3Node &object, const GraphTemplate *graph = nullptr);
 		
+		/// Sets the document the following statements belong to, without writing its scope.
+		void source(const std::string &source)
+		{
+			m_source = source;
+		}
+		
+		/// Prepares the writer for a new output document on the same stream.
+		void reset()
+		{
+			m_formatter.reset();
+			m_source.clear();
+			m_count = 0;
+		}
+		
+		/// Writes numbers in their canonical form instead of keeping their lexical form.
+		void normalizeNumbers(bool normalize)
+		{
+			m_formatter.numbers().normalize(normalize);
+		}
+		
+		void statistics(std::ostream &out) const override
+		{
+			out << "uri cache: " << m_formatter.hits() << " hits, " << m_formatter.misses() << " misses" << std::endl;
+		}
+		
+		bool streamsFormulas() const override { return true; }
+		
+		void beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula) override;
+		
+		void formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object) override
+		{
+			m_formatter.triple(subject, property, object);
+		}
+		
+		void endFormula() override;
+		
 		void start() override { writePrologue(); }
 		void end() override { writeEpilogue(); }
 		
+		/// Copies statements formatted by another writer to the output.
+		void append(const char *data, std::size_t size)
+		{
+			m_out.write(data, size);
+		}
+		
+		/// Adds the number of triples in statements copied with append().
+		void addCount(std::uint64_t count)
+		{
+			m_count += count;
+		}
+		
 		void prefix(const std::string &prefix, const std::string &ns) override
 		{
 			m_out << "pfx('";
@@ -268,3 +381,5 @@ namespace n3 {
 	};
 
 }
+
+#endif /* CARL_CN3WRITER_HH */
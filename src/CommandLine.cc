@@ -16,17 +16,129 @@
 
 #include "CommandLine.hh"
 
+#include <stdexcept>
+
 namespace n3 {
+	
+	namespace {
+		
+		// matches "--name=value" and "--name value"
+		bool longOption(const std::string &arg, const std::string &name, int &i, int argc, char *argv[], Optional<std::string> &value)
+		{
+			if (arg.compare(0, name.length(), name) != 0)
+				return false;
+			
+			if (arg.length() == name.length()) {
+				value = i + 1 < argc ? std::string(argv[++i]) : std::string();
+				
+				return true;
+			}
+			
+			if (arg[name.length()] == '=') {
+				value = arg.substr(name.length() + 1);
+				
+				return true;
+			}
+			
+			return false;
+		}
+		
+		bool toUnsigned(const std::string &s, unsigned &value)
+		{
+			if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos)
+				return false;
+			
+			try {
+				value = static_cast<unsigned>(std::stoul(s));
+			} catch (std::out_of_range &) {
+				return false;
+			}
+			
+			return true;
+		}
+		
+		// a number of bytes with an optional K, M or G suffix
+		bool toSize(const std::string &s, std::size_t &value)
+		{
+			std::size_t shift = 0;
+			std::string digits = s;
+			if (!s.empty()) {
+				switch (s.back()) {
+					case 'K': case 'k': shift = 10; break;
+					case 'M': case 'm': shift = 20; break;
+					case 'G': case 'g': shift = 30; break;
+				}
+				if (shift)
+					digits.pop_back();
+			}
+			
+			if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos)
+				return false;
+			
+			unsigned long long n;
+			try {
+				n = std::stoull(digits);
+			} catch (std::out_of_range &) {
+				return false;
+			}
+			
+			if (n > (static_cast<std::size_t>(-1) >> shift))
+				return false;
+			
+			value = static_cast<std::size_t>(n) << shift;
+			
+			return true;
+		}
+	}
 
 	CommandLine CommandLine::parse(int argc, char *argv[])
 	{
-		CommandLine opt;
+		CommandLine opt = CommandLine();
 		
 		bool error = false, stop = false;
+		Optional<std::string> maxMemory;
+		Optional<std::string> readAhead;
+		Optional<std::string> readAheadDepth;
+		Optional<std::string> maxRequest;
+		Optional<std::string> idleTimeout;
 		for (int i = 1; i < argc && !error; i++) {
 			std::string arg = argv[i];
 			if (!stop) {
-				if (arg.find("-o") == 0) {
+				if (longOption(arg, "--serve", i, argc, argv, opt.serve)) {
+					error = opt.serve->empty();
+				} else if (longOption(arg, "--outdir", i, argc, argv, opt.outdir)) {
+					error = opt.outdir->empty();
+				} else if (longOption(arg, "--output-format", i, argc, argv, opt.format)) {
+					error = opt.format->empty();
+				} else if (longOption(arg, "--max-memory", i, argc, argv, maxMemory)) {
+					error = !toSize(*maxMemory, opt.maxMemory) || opt.maxMemory == 0;
+				} else if (longOption(arg, "--read-ahead", i, argc, argv, readAhead)) {
+					error = !toSize(*readAhead, opt.readAhead) || opt.readAhead == 0;
+				} else if (longOption(arg, "--read-ahead-depth", i, argc, argv, readAheadDepth)) {
+					error = !toUnsigned(*readAheadDepth, opt.readAheadDepth) || opt.readAheadDepth < 2;
+				} else if (longOption(arg, "--max-request", i, argc, argv, maxRequest)) {
+					error = !toSize(*maxRequest, opt.maxRequest) || opt.maxRequest == 0;
+				} else if (longOption(arg, "--idle-timeout", i, argc, argv, idleTimeout)) {
+					unsigned seconds;
+					error = !toUnsigned(*idleTimeout, seconds);
+					opt.idleTimeout = seconds;
+				} else if (arg == "--incremental") {
+					opt.incremental = true;
+				} else if (arg == "--framed") {
+					opt.framed = true;
+				} else if (arg == "--deterministic") {
+					opt.deterministic = true;
+				} else if (arg == "--stats") {
+					opt.stats = true;
+				} else if (arg == "--normalize-numbers") {
+					opt.normalizeNumbers = true;
+				} else if (arg == "--typed-values") {
+					opt.typedValues = true;
+				} else if (arg == "--stream-rules") {
+					opt.streamRules = true;
+				} else if (arg == "--pipeline") {
+					opt.pipeline = true;
+				} else if (arg.find("-o") == 0) {
 					if (arg[2] == '=')
 						opt.output = arg.substr(3);
 					else {
@@ -46,6 +158,17 @@ namespace n3 {
 							opt.base = std::string(argv[++i]);
 					}
 					error = opt.base->empty();
+				} else if (arg.find("-j") == 0) {
+					std::string jobs;
+					if (arg[2] == '=')
+						jobs = arg.substr(3);
+					else {
+						jobs = arg.substr(2);
+						
+						if (jobs.empty() && i + 1 < argc)
+							jobs = argv[++i];
+					}
+					error = !toUnsigned(jobs, opt.jobs) || opt.jobs == 0;
 				} else if (arg == "-h") {
 					opt.help = true;
 				} else if (arg == "--") {
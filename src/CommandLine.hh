@@ -30,7 +30,24 @@ namespace n3 {
 		bool help;
 		std::vector<std::string> inputs;
 		Optional<std::string> output;
+		Optional<std::string> format;
 		Optional<std::string> base;
+		Optional<std::string> serve;
+		Optional<std::string> outdir;
+		bool incremental;
+		bool framed;
+		bool deterministic;
+		bool stats;
+		bool normalizeNumbers;
+		bool typedValues;
+		bool streamRules;
+		bool pipeline;
+		unsigned jobs;
+		std::size_t maxMemory; // 0 means no limit
+		std::size_t readAhead; // the chunk size of the read-ahead thread, 0 means no read-ahead
+		unsigned readAheadDepth;
+		std::size_t maxRequest; // the request size limit of --serve and --framed, 0 means the default
+		Optional<unsigned> idleTimeout;
 		
 		static CommandLine parse(int argc, char *argv[]);
 	};
@@ -0,0 +1,496 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Compression.hh"
+
+#include <fstream>
+#include <stdexcept>
+
+#ifdef CARL_WITH_ZLIB
+#	include <zlib.h>
+#endif
+#ifdef CARL_WITH_BZIP2
+#	include <bzlib.h>
+#endif
+#ifdef CARL_WITH_ZSTD
+#	include <zstd.h>
+#endif
+
+
+namespace n3 {
+	
+	namespace {
+		
+		const std::size_t INPUT_SIZE = 64 * 1024;
+		
+		///
+		/// Common part of the decompressing sources: the compressed input and its buffer.
+		///
+		class Decompressor : public ByteSource {
+		protected:
+			std::unique_ptr<ByteSource> m_in;
+			std::unique_ptr<char[]> m_buffer;
+			bool m_inputEnd;
+			
+			/// Reads the next block of compressed input into the buffer, returns its size, 0 at the end.
+			std::size_t next()
+			{
+				std::size_t n = m_inputEnd ? 0 : m_in->read(m_buffer.get(), INPUT_SIZE);
+				if (n == 0)
+					m_inputEnd = true;
+				
+				return n;
+			}
+			
+		public:
+			explicit Decompressor(std::unique_ptr<ByteSource> in) : ByteSource(), m_in(std::move(in)), m_buffer(new char[INPUT_SIZE]), m_inputEnd(false) {}
+			
+			void interrupt() override { m_in->interrupt(); }
+		};
+		
+#ifdef CARL_WITH_ZLIB
+		/// Decompresses gzip, concatenated members are decompressed one after the other.
+		class GzipSource : public Decompressor {
+			
+			z_stream m_stream;
+			bool m_memberEnd; // no member is partially decompressed
+			
+		public:
+			explicit GzipSource(std::unique_ptr<ByteSource> in) : Decompressor(std::move(in)), m_stream(), m_memberEnd(true)
+			{
+				if (inflateInit2(&m_stream, 15 + 16) != Z_OK)
+					throw InputException("error initializing gzip decompression");
+			}
+			
+			~GzipSource()
+			{
+				inflateEnd(&m_stream);
+			}
+			
+			std::size_t read(char *data, std::size_t size) override
+			{
+				m_stream.next_out  = reinterpret_cast<Bytef *>(data);
+				m_stream.avail_out = static_cast<uInt>(size);
+				
+				while (m_stream.avail_out == size) {
+					if (m_stream.avail_in == 0) {
+						std::size_t n = next();
+						if (n == 0) {
+							if (!m_memberEnd)
+								throw InputException("truncated gzip input");
+							
+							break;
+						}
+						
+						m_stream.next_in  = reinterpret_cast<Bytef *>(m_buffer.get());
+						m_stream.avail_in = static_cast<uInt>(n);
+					}
+					
+					m_memberEnd = false;
+					
+					int result = inflate(&m_stream, Z_NO_FLUSH);
+					if (result == Z_STREAM_END) {
+						m_memberEnd = true;
+						inflateReset(&m_stream);
+					} else if (result != Z_OK) {
+						throw InputException("corrupt gzip input");
+					}
+				}
+				
+				return size - m_stream.avail_out;
+			}
+		};
+#endif /* CARL_WITH_ZLIB */
+		
+#ifdef CARL_WITH_BZIP2
+		/// Decompresses bzip2, concatenated streams are decompressed one after the other.
+		class Bzip2Source : public Decompressor {
+			
+			bz_stream m_stream;
+			bool m_streamEnd; // no stream is partially decompressed
+			
+		public:
+			explicit Bzip2Source(std::unique_ptr<ByteSource> in) : Decompressor(std::move(in)), m_stream(), m_streamEnd(true)
+			{
+				if (BZ2_bzDecompressInit(&m_stream, 0, 0) != BZ_OK)
+					throw InputException("error initializing bzip2 decompression");
+			}
+			
+			~Bzip2Source()
+			{
+				BZ2_bzDecompressEnd(&m_stream);
+			}
+			
+			std::size_t read(char *data, std::size_t size) override
+			{
+				m_stream.next_out  = data;
+				m_stream.avail_out = static_cast<unsigned>(size);
+				
+				while (m_stream.avail_out == size) {
+					if (m_stream.avail_in == 0) {
+						std::size_t n = next();
+						if (n == 0) {
+							if (!m_streamEnd)
+								throw InputException("truncated bzip2 input");
+							
+							break;
+						}
+						
+						m_stream.next_in  = m_buffer.get();
+						m_stream.avail_in = static_cast<unsigned>(n);
+					}
+					
+					m_streamEnd = false;
+					
+					int result = BZ2_bzDecompress(&m_stream);
+					if (result == BZ_STREAM_END) {
+						m_streamEnd = true;
+						
+						// restart for a following stream, keeping the unused input
+						char *in = m_stream.next_in;
+						unsigned available = m_stream.avail_in;
+						char *out = m_stream.next_out;
+						unsigned space = m_stream.avail_out;
+						
+						BZ2_bzDecompressEnd(&m_stream);
+						m_stream = bz_stream();
+						if (BZ2_bzDecompressInit(&m_stream, 0, 0) != BZ_OK)
+							throw InputException("error initializing bzip2 decompression");
+						
+						m_stream.next_in   = in;
+						m_stream.avail_in  = available;
+						m_stream.next_out  = out;
+						m_stream.avail_out = space;
+					} else if (result != BZ_OK) {
+						throw InputException("corrupt bzip2 input");
+					}
+				}
+				
+				return size - m_stream.avail_out;
+			}
+		};
+#endif /* CARL_WITH_BZIP2 */
+		
+#ifdef CARL_WITH_ZSTD
+		/// Decompresses zstd, a file can hold any number of frames.
+		class ZstdSource : public Decompressor {
+			
+			ZSTD_DStream *m_stream;
+			ZSTD_inBuffer m_input;
+			bool m_frameEnd; // no frame is partially decompressed
+			
+		public:
+			explicit ZstdSource(std::unique_ptr<ByteSource> in) : Decompressor(std::move(in)), m_stream(ZSTD_createDStream()), m_input(), m_frameEnd(true)
+			{
+				if (!m_stream || ZSTD_isError(ZSTD_initDStream(m_stream))) {
+					ZSTD_freeDStream(m_stream);
+					throw InputException("error initializing zstd decompression");
+				}
+			}
+			
+			~ZstdSource()
+			{
+				ZSTD_freeDStream(m_stream);
+			}
+			
+			std::size_t read(char *data, std::size_t size) override
+			{
+				ZSTD_outBuffer output = { data, size, 0 };
+				
+				while (output.pos == 0) {
+					if (m_input.pos == m_input.size) {
+						std::size_t n = next();
+						if (n == 0) {
+							if (!m_frameEnd)
+								throw InputException("truncated zstd input");
+							
+							break;
+						}
+						
+						m_input.src  = m_buffer.get();
+						m_input.size = n;
+						m_input.pos  = 0;
+					}
+					
+					std::size_t result = ZSTD_decompressStream(m_stream, &output, &m_input);
+					if (ZSTD_isError(result))
+						throw InputException(std::string("corrupt zstd input: ") + ZSTD_getErrorName(result));
+					
+					m_frameEnd = result == 0;
+				}
+				
+				return output.pos;
+			}
+		};
+#endif /* CARL_WITH_ZSTD */
+	}
+	
+	Compression::Format Compression::detect(const char *data, std::size_t size)
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+		
+		if (size >= 2 && p[0] == 0x1F && p[1] == 0x8B)
+			return GZIP;
+		
+		if (size >= 4 && p[0] == 'B' && p[1] == 'Z' && p[2] == 'h' && p[3] >= '1' && p[3] <= '9')
+			return BZIP2;
+		
+		if (size >= 4 && p[0] == 0x28 && p[1] == 0xB5 && p[2] == 0x2F && p[3] == 0xFD)
+			return ZSTD;
+		
+		return NONE;
+	}
+	
+	Compression::Format Compression::detect(const std::string &path)
+	{
+		char magic[MAGIC_SIZE];
+		
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		in.read(magic, MAGIC_SIZE);
+		
+		return detect(magic, static_cast<std::size_t>(in.gcount()));
+	}
+	
+	bool Compression::supported(Format format)
+	{
+		switch (format) {
+			case NONE:
+				return true;
+			case GZIP:
+#ifdef CARL_WITH_ZLIB
+				return true;
+#else
+				return false;
+#endif
+			case BZIP2:
+#ifdef CARL_WITH_BZIP2
+				return true;
+#else
+				return false;
+#endif
+			case ZSTD:
+#ifdef CARL_WITH_ZSTD
+				return true;
+#else
+				return false;
+#endif
+		}
+		
+		return false;
+	}
+	
+	const char *Compression::name(Format format)
+	{
+		switch (format) {
+			case GZIP:  return "gzip";
+			case BZIP2: return "bzip2";
+			case ZSTD:  return "zstd";
+			default:    return "none";
+		}
+	}
+	
+	Compression::Format Compression::fromExtension(const std::string &path)
+	{
+		struct Extension {
+			const char *extension;
+			Format format;
+		};
+		
+		static const Extension EXTENSIONS[] = { { ".gz", GZIP }, { ".bz2", BZIP2 }, { ".zst", ZSTD } };
+		
+		for (const Extension &e : EXTENSIONS) {
+			std::size_t n = std::char_traits<char>::length(e.extension);
+			if (path.size() > n && path.compare(path.size() - n, n, e.extension) == 0)
+				return e.format;
+		}
+		
+		return NONE;
+	}
+	
+	void Compression::compress(Format format, const std::string &block, std::string &compressed)
+	{
+		switch (format) {
+#ifdef CARL_WITH_ZLIB
+			case GZIP: {
+				z_stream stream = z_stream();
+				if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+					throw std::runtime_error("error initializing gzip compression");
+				
+				compressed.resize(deflateBound(&stream, static_cast<uLong>(block.size())));
+				
+				stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(block.data()));
+				stream.avail_in  = static_cast<uInt>(block.size());
+				stream.next_out  = reinterpret_cast<Bytef *>(&compressed[0]);
+				stream.avail_out = static_cast<uInt>(compressed.size());
+				
+				int result = deflate(&stream, Z_FINISH);
+				compressed.resize(stream.total_out);
+				deflateEnd(&stream);
+				
+				if (result != Z_STREAM_END)
+					throw std::runtime_error("gzip compression failed");
+				
+				return;
+			}
+#endif
+#ifdef CARL_WITH_BZIP2
+			case BZIP2: {
+				unsigned size = static_cast<unsigned>(block.size() + block.size() / 100 + 601);
+				compressed.resize(size);
+				
+				if (BZ2_bzBuffToBuffCompress(&compressed[0], &size, const_cast<char *>(block.data()), static_cast<unsigned>(block.size()), 9, 0, 0) != BZ_OK)
+					throw std::runtime_error("bzip2 compression failed");
+				
+				compressed.resize(size);
+				
+				return;
+			}
+#endif
+#ifdef CARL_WITH_ZSTD
+			case ZSTD: {
+				compressed.resize(ZSTD_compressBound(block.size()));
+				
+				std::size_t size = ZSTD_compress(&compressed[0], compressed.size(), block.data(), block.size(), 3);
+				if (ZSTD_isError(size))
+					throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+				
+				compressed.resize(size);
+				
+				return;
+			}
+#endif
+			default:
+				throw std::runtime_error(std::string(name(format)) + " compression is not supported by this build");
+		}
+	}
+	
+	std::unique_ptr<ByteSource> Compression::open(int fd)
+	{
+		char magic[MAGIC_SIZE];
+		std::size_t n = FdSource::readFully(fd, magic, MAGIC_SIZE);
+		
+		Format format = detect(magic, n);
+		if (!supported(format))
+			throw InputException(std::string(name(format)) + " compressed input is not supported by this build");
+		
+		std::unique_ptr<ByteSource> source(new FdSource(fd, std::string(magic, n)));
+		
+		switch (format) {
+#ifdef CARL_WITH_ZLIB
+			case GZIP:
+				return std::unique_ptr<ByteSource>(new GzipSource(std::move(source)));
+#endif
+#ifdef CARL_WITH_BZIP2
+			case BZIP2:
+				return std::unique_ptr<ByteSource>(new Bzip2Source(std::move(source)));
+#endif
+#ifdef CARL_WITH_ZSTD
+			case ZSTD:
+				return std::unique_ptr<ByteSource>(new ZstdSource(std::move(source)));
+#endif
+			default:
+				return source;
+		}
+	}
+
+	
+	CompressingStreamBuf::CompressingStreamBuf(std::ostream &out, Compression::Format format, unsigned threads, std::size_t blockSize)
+		: std::streambuf(), m_out(out), m_format(format), m_blockSize(blockSize ? blockSize : DEFAULT_BLOCK_SIZE), m_maxPending(2 * (threads ? threads : 1)), m_block(), m_pending(), m_pool(threads ? threads : 1)
+	{
+		newBlock();
+	}
+	
+	CompressingStreamBuf::~CompressingStreamBuf()
+	{
+		try {
+			sync();
+		} catch (...) {
+			// the output is incomplete
+		}
+	}
+	
+	void CompressingStreamBuf::newBlock()
+	{
+		m_block = std::make_shared<Block>();
+		m_block->data.resize(m_blockSize);
+		
+		char *p = &m_block->data[0];
+		setp(p, p + m_blockSize);
+	}
+	
+	void CompressingStreamBuf::submit()
+	{
+		std::size_t size = pptr() - pbase();
+		if (size == 0)
+			return;
+		
+		while (m_pending.size() >= m_maxPending)
+			writeFirst();
+		
+		std::shared_ptr<Block> block = std::move(m_block);
+		block->data.resize(size);
+		m_pending.emplace_back(block, block->done.get_future());
+		
+		Compression::Format format = m_format;
+		m_pool.execute([block, format] {
+			try {
+				Compression::compress(format, block->data, block->compressed);
+				block->done.set_value();
+			} catch (...) {
+				block->done.set_exception(std::current_exception());
+			}
+		});
+		
+		newBlock();
+	}
+	
+	void CompressingStreamBuf::writeFirst()
+	{
+		std::shared_ptr<Block> block = std::move(m_pending.front().first);
+		std::future<void> done = std::move(m_pending.front().second);
+		m_pending.pop_front();
+		
+		done.get(); // rethrows an exception of the compression
+		
+		m_out.write(block->compressed.data(), block->compressed.size());
+	}
+	
+	CompressingStreamBuf::int_type CompressingStreamBuf::overflow(int_type c)
+	{
+		submit();
+		
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		
+		return traits_type::not_eof(c);
+	}
+	
+	int CompressingStreamBuf::sync()
+	{
+		submit();
+		
+		while (!m_pending.empty())
+			writeFirst();
+		
+		m_out.flush();
+		
+		return m_out ? 0 : -1;
+	}
+
+}
@@ -0,0 +1,115 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_COMPRESSION_HH
+#define CARL_COMPRESSION_HH
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+
+#include "Streams.hh"
+#include "ThreadPool.hh"
+
+namespace n3 {
+	
+	///
+	/// Recognizes compressed inputs by their magic bytes and decompresses them.
+	/// Every format needs its library: build with CARL_WITH_ZLIB, CARL_WITH_BZIP2
+	/// or CARL_WITH_ZSTD defined (make WITH_ZLIB=1 WITH_BZIP2=1 WITH_ZSTD=1).
+	///
+	class Compression {
+	public:
+		
+		enum Format { NONE, GZIP, BZIP2, ZSTD };
+		
+		/// The number of bytes detect() needs.
+		static const std::size_t MAGIC_SIZE = 4;
+		
+		static Format detect(const char *data, std::size_t size);
+		
+		/// Reads the first bytes of a file, returns NONE if the file can not be read.
+		static Format detect(const std::string &path);
+		
+		static bool supported(Format format);
+		
+		static const char *name(Format format);
+		
+		/// The format of an output file by its extension: .gz, .bz2 or .zst.
+		static Format fromExtension(const std::string &path);
+		
+		/// Compresses a block into a complete gzip member, bzip2 stream or zstd frame,
+		/// so concatenated blocks form a valid file. Throws std::runtime_error on failure.
+		static void compress(Format format, const std::string &block, std::string &compressed);
+		
+		/// Returns a source with the decompressed contents of fd, or with the
+		/// contents as they are when they are not compressed. Throws
+		/// InputException when the format is not supported by this build or fd can not be read.
+		static std::unique_ptr<ByteSource> open(int fd);
+	};
+
+	
+	///
+	/// Output stream buffer compressing blocks of its output in parallel on a
+	/// pool of threads. Every block is compressed independently and written to
+	/// out in order; sync() (and flushing the stream) writes all pending blocks.
+	///
+	class CompressingStreamBuf : public std::streambuf {
+		
+		struct Block {
+			std::string data;
+			std::string compressed;
+			std::promise<void> done;
+		};
+		
+		std::ostream &m_out;
+		Compression::Format m_format;
+		std::size_t m_blockSize;
+		std::size_t m_maxPending;
+		std::shared_ptr<Block> m_block;
+		std::deque<std::pair<std::shared_ptr<Block>, std::future<void>>> m_pending;
+		
+		ThreadPool m_pool; // last, its destructor waits for the tasks using the blocks
+		
+		void submit();
+		void writeFirst();
+		void newBlock();
+		
+	protected:
+		int_type overflow(int_type c) override;
+		int sync() override;
+		
+	public:
+		static const std::size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+		
+		/// The format must be supported, see Compression::supported().
+		CompressingStreamBuf(std::ostream &out, Compression::Format format, unsigned threads = ThreadPool::defaultSize(), std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+		
+		CompressingStreamBuf(const CompressingStreamBuf &) = delete;
+		CompressingStreamBuf &operator=(const CompressingStreamBuf &) = delete;
+		
+		~CompressingStreamBuf();
+	};
+
+}
+
+#endif /* CARL_COMPRESSION_HH */
@@ -0,0 +1,83 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Datatypes.hh"
+#include "Model.hh"
+
+#include <mutex>
+#include <unordered_set>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		struct Table {
+			std::mutex mutex;
+			std::unordered_set<std::string> iris;
+		};
+		
+		Table &table()
+		{
+			static Table table;
+			
+			return table;
+		}
+		
+		bool isLocalName(const std::string &iri, const char *name, std::size_t length)
+		{
+			return iri.compare(XSD::NS.length(), length, name, length) == 0;
+		}
+	}
+	
+	Datatypes::Kind Datatypes::kind(const std::string &iri)
+	{
+		std::size_t length = iri.length();
+		
+		if (length < XSD::NS.length() + 6 || length > XSD::NS.length() + 7 || iri.compare(0, XSD::NS.length(), XSD::NS) != 0)
+			return OTHER;
+		
+		// the local names are distinguished by their length and first character
+		switch (length - XSD::NS.length() + iri[XSD::NS.length()]) {
+			case 7 + 'i': return isLocalName(iri, "integer", 7) ? INTEGER : OTHER;
+			case 7 + 'd': return isLocalName(iri, "decimal", 7) ? DECIMAL : OTHER;
+			case 7 + 'b': return isLocalName(iri, "boolean", 7) ? BOOLEAN : OTHER;
+			case 6 + 'd': return isLocalName(iri, "double",  6) ? DOUBLE  : OTHER;
+			case 6 + 's': return isLocalName(iri, "string",  6) ? STRING  : OTHER;
+			default:      return OTHER;
+		}
+	}
+	
+	Datatypes::Entry Datatypes::intern(const std::string &iri)
+	{
+		Table &t = table();
+		
+		std::lock_guard<std::mutex> lock(t.mutex);
+		
+		auto i = t.iris.find(iri);
+		if (i == t.iris.end() && t.iris.size() < MAX_INTERNED)
+			i = t.iris.insert(iri).first;
+		
+		if (i != t.iris.end())
+			return Entry { &*i, kind(iri), nullptr };
+		
+		std::shared_ptr<const std::string> owned = std::make_shared<const std::string>(iri);
+		
+		return Entry { owned.get(), kind(iri), owned };
+	}
+
+}
@@ -0,0 +1,55 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_DATATYPES_HH
+#define CARL_DATATYPES_HH
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace n3 {
+	
+	///
+	/// Interns datatype IRIs: every distinct IRI is stored once for the lifetime of the program,
+	/// so literals can point to it instead of keeping a copy. Safe to use from several threads.
+	/// Only the first MAX_INTERNED IRIs are kept, so a long running process does not grow with
+	/// every datatype its clients make up; the literals of later IRIs share a counted copy.
+	///
+	class Datatypes {
+	public:
+		
+		enum Kind { OTHER, INTEGER, DECIMAL, DOUBLE, BOOLEAN, STRING };
+		
+		struct Entry {
+			const std::string *iri;
+			Kind kind;
+			std::shared_ptr<const std::string> owned; // keeps iri alive when it is not interned
+		};
+		
+		static const std::size_t MAX_INTERNED = 1024;
+		
+		/// The interned IRI and its kind, the XSD types with a literal class of their own are recognized.
+		static Entry intern(const std::string &iri);
+		
+		/// The kind of iri, without interning it.
+		static Kind kind(const std::string &iri);
+	};
+
+}
+
+#endif /* CARL_DATATYPES_HH */
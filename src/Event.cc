@@ -0,0 +1,103 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Event.hh"
+
+
+namespace n3 {
+	
+	Event::Event(Type type, const N3Node &subject, const N3Node &property, const N3Node *object) :
+		type(type),
+		first(),
+		second(),
+		seed(0),
+		subject(subject.clone()),
+		property(property.clone()),
+		object(object ? object->clone() : nullptr)
+	{
+	}
+	
+	void Event::replay(TripleSink &sink) const
+	{
+		switch (type) {
+			case DOCUMENT:
+				sink.document(first);
+				break;
+			case DETERMINISTIC:
+				sink.deterministic(seed);
+				break;
+			case PREFIX:
+				sink.prefix(first, second);
+				break;
+			case TRIPLE:
+				sink.triple(*subject, *property, *object);
+				break;
+			case BEGIN_FORMULA:
+				sink.beginFormula(*subject, *property, static_cast<const GraphTemplate &>(*object));
+				break;
+			case FORMULA_TRIPLE:
+				sink.formulaTriple(*subject, *property, *object);
+				break;
+			case END_FORMULA:
+				sink.endFormula();
+				break;
+		}
+	}
+
+	
+	void EventList::document(const std::string &source)
+	{
+		add(Event(Event::DOCUMENT, source));
+	}
+	
+	void EventList::deterministic(std::uint64_t seed)
+	{
+		add(Event(Event::DETERMINISTIC, seed));
+	}
+	
+	void EventList::prefix(const std::string &prefix, const std::string &ns)
+	{
+		add(Event(Event::PREFIX, prefix, ns));
+	}
+	
+	void EventList::triple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		add(Event(Event::TRIPLE, subject, property, &object));
+	}
+	
+	void EventList::beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula)
+	{
+		add(Event(Event::BEGIN_FORMULA, subject, property, &formula));
+	}
+	
+	void EventList::formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		add(Event(Event::FORMULA_TRIPLE, subject, property, &object));
+	}
+	
+	void EventList::endFormula()
+	{
+		add(Event(Event::END_FORMULA));
+	}
+	
+	void EventList::replay(TripleSink &sink) const
+	{
+		for (const Event &event : m_events)
+			event.replay(sink);
+	}
+
+}
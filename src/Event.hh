@@ -0,0 +1,91 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_EVENT_HH
+#define CARL_EVENT_HH
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Parser.hh"
+
+namespace n3 {
+	
+	///
+	/// A recorded TripleSink call, to replay it later, possibly on another thread.
+	/// The nodes are copies owned by the event.
+	///
+	struct Event {
+		
+		enum Type { DOCUMENT, DETERMINISTIC, PREFIX, TRIPLE, BEGIN_FORMULA, FORMULA_TRIPLE, END_FORMULA };
+		
+		Type type;
+		std::string first;  // the source of a document, the prefix of a prefix
+		std::string second; // the namespace of a prefix
+		std::uint64_t seed; // the seed of DETERMINISTIC
+		std::unique_ptr<N3Node> subject;
+		std::unique_ptr<N3Node> property;
+		std::unique_ptr<N3Node> object; // the formula of BEGIN_FORMULA
+		
+		explicit Event(Type type, const std::string &first = std::string(), const std::string &second = std::string()) :
+			type(type), first(first), second(second), seed(0), subject(), property(), object() {}
+		
+		Event(Type type, std::uint64_t seed) : type(type), first(), second(), seed(seed), subject(), property(), object() {}
+		
+		/// Copies the nodes, object may be null.
+		/// Nothing is left behind when a copy fails, the event is only recorded once complete.
+		Event(Type type, const N3Node &subject, const N3Node &property, const N3Node *object);
+		
+		/// Makes the same call on sink as the one recorded.
+		void replay(TripleSink &sink) const;
+	};
+
+	
+	///
+	/// TripleSink recording the calls in memory, to replay them later in order.
+	///
+	class EventList : public DefaultTripleSink {
+		
+		std::vector<Event> m_events;
+		bool m_streamsFormulas;
+		
+		void add(Event &&event) { m_events.push_back(std::move(event)); }
+		
+	public:
+		/// Accepts streamed formulas when streamsFormulas is set, to replay them on a sink that does.
+		explicit EventList(bool streamsFormulas = false) : DefaultTripleSink(), m_events(), m_streamsFormulas(streamsFormulas) {}
+		
+		void document(const std::string &source) override;
+		void deterministic(std::uint64_t seed) override;
+		void prefix(const std::string &prefix, const std::string &ns) override;
+		void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override;
+		
+		bool streamsFormulas() const override { return m_streamsFormulas; }
+		void beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula) override;
+		void formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object) override;
+		void endFormula() override;
+		
+		void replay(TripleSink &sink) const;
+		
+		void clear() { m_events.clear(); }
+	};
+
+}
+
+#endif /* CARL_EVENT_HH */
@@ -0,0 +1,95 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Frame.hh"
+
+namespace n3 {
+	
+	namespace frame {
+		
+		namespace {
+			
+			bool readLength(std::istream &in, std::uint32_t &length, bool optional)
+			{
+				unsigned char b[4];
+				
+				if (!in.read(reinterpret_cast<char *>(b), 4)) {
+					if (optional && in.gcount() == 0)
+						return false;
+					
+					throw FrameException("truncated frame");
+				}
+				
+				length = static_cast<std::uint32_t>(b[0]) << 24 | static_cast<std::uint32_t>(b[1]) << 16 | static_cast<std::uint32_t>(b[2]) << 8 | b[3];
+				
+				return true;
+			}
+			
+			void readData(std::istream &in, std::uint32_t length, std::string &data)
+			{
+				data.resize(length);
+				
+				if (length && !in.read(&data[0], length))
+					throw FrameException("truncated frame");
+			}
+			
+			void writeLength(std::ostream &out, std::size_t length)
+			{
+				if (length > MAX_LENGTH)
+					throw FrameException("frame too large");
+				
+				char b[4] = {
+					static_cast<char>(length >> 24),
+					static_cast<char>(length >> 16),
+					static_cast<char>(length >> 8),
+					static_cast<char>(length)
+				};
+				
+				out.write(b, 4);
+			}
+		}
+		
+		bool readRequest(std::istream &in, std::string &base, std::string &document, std::size_t maxRequest)
+		{
+			std::uint32_t length;
+			
+			if (!readLength(in, length, true))
+				return false;
+			
+			if (length > maxRequest)
+				throw FrameException("request too large");
+			
+			readData(in, length, base);
+			readLength(in, length, false);
+			
+			if (length > maxRequest - base.length())
+				throw FrameException("request too large");
+			
+			readData(in, length, document);
+			
+			return true;
+		}
+		
+		void writeResponse(std::ostream &out, Status status, const std::string &body)
+		{
+			out.put(static_cast<char>(status));
+			writeLength(out, body.length());
+			out.write(body.data(), body.length());
+		}
+	}
+
+}
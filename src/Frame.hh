@@ -0,0 +1,66 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_FRAME_HH
+#define CARL_FRAME_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace n3 {
+	
+	class FrameException : public std::runtime_error {
+	public:
+		explicit FrameException(const std::string &message = std::string()) : std::runtime_error(message) {}
+	};
+	
+	///
+	/// Length-prefixed framing used to exchange documents with a long running carl process.
+	/// All lengths are unsigned 32 bit integers in network byte order.
+	///
+	///   request  := base-length base document-length document
+	///   response := status body-length body
+	///
+	/// An empty base means that the default base uri applies. The status is a single byte,
+	/// when it is OK the body contains the N3P translation, otherwise an error message.
+	///
+	namespace frame {
+		
+		enum Status : std::uint8_t {
+			OK    = 0,
+			ERROR = 1
+		};
+		
+		const std::uint32_t MAX_LENGTH = 0xFFFFFFFFu;
+		
+		/// The default limit on the size of a request, base and document together.
+		const std::size_t DEFAULT_MAX_REQUEST = 64u << 20;
+		
+		/// Returns false when the input ends before the start of a request.
+		/// Throws FrameException when the request is larger than maxRequest bytes, before reading it.
+		bool readRequest(std::istream &in, std::string &base, std::string &document, std::size_t maxRequest = DEFAULT_MAX_REQUEST);
+		
+		void writeResponse(std::ostream &out, Status status, const std::string &body);
+	}
+
+}
+
+#endif /* CARL_FRAME_HH */
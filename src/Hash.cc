@@ -0,0 +1,60 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Hash.hh"
+
+#include <fstream>
+#include <memory>
+
+namespace n3 {
+	
+	bool Hash64::file(const std::string &path, std::uint64_t &value)
+	{
+		const std::size_t BUFFER_SIZE = 64 * 1024;
+		
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		if (!in)
+			return false;
+		
+		std::unique_ptr<char[]> buffer(new char[BUFFER_SIZE]);
+		
+		Hash64 hash;
+		while (in.read(buffer.get(), BUFFER_SIZE) || in.gcount() > 0)
+			hash.update(buffer.get(), in.gcount());
+		
+		if (in.bad())
+			return false;
+		
+		value = hash.value();
+		
+		return true;
+	}
+	
+	std::string Hash64::toHex(std::uint64_t value)
+	{
+		static const char HEX_CHAR[] = "0123456789abcdef";
+		
+		std::string s(16, '0');
+		for (int i = 15; i >= 0; i--) {
+			s[i] = HEX_CHAR[value & 0xF];
+			value >>= 4;
+		}
+		
+		return s;
+	}
+
+}
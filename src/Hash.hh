@@ -0,0 +1,67 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_HASH_HH
+#define CARL_HASH_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace n3 {
+	
+	///
+	/// 64 bit FNV-1a hash, see http://www.isthe.com/chongo/tech/comp/fnv/
+	///
+	class Hash64 {
+		
+		static const std::uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+		static const std::uint64_t PRIME        = 0x100000001b3ull;
+		
+		std::uint64_t m_value;
+		
+	public:
+		Hash64() : m_value(OFFSET_BASIS) {}
+		
+		void update(const char *data, std::size_t size)
+		{
+			std::uint64_t h = m_value;
+			
+			for (std::size_t i = 0; i < size; i++) {
+				h ^= static_cast<unsigned char>(data[i]);
+				h *= PRIME;
+			}
+			
+			m_value = h;
+		}
+		
+		void update(const std::string &s)
+		{
+			update(s.data(), s.length());
+		}
+		
+		std::uint64_t value() const { return m_value; }
+		
+		/// Hashes the contents of a file, returns false when the file can not be read.
+		static bool file(const std::string &path, std::uint64_t &value);
+		
+		static std::string toHex(std::uint64_t value);
+	};
+
+}
+
+#endif /* CARL_HASH_HH */
@@ -20,113 +20,393 @@
 #include <memory>
 #include <chrono>
 #include <iomanip>
+#include <stdexcept>
+#include <iterator>
+#include <cstdint>
 
 #include "CommandLine.hh"
 #include "Parser.hh"
+#include "Hash.hh"
 #include "Uri.hh"
-#include "CN3Writer.hh"
 #include "Util.hh"
 #include "Version.hh"
+#include "Server.hh"
+#include "Translator.hh"
+#include "Frame.hh"
+#include "ThreadPool.hh"
+#include "Batch.hh"
+#include "Memory.hh"
+#include "Pipeline.hh"
+#include "SinkRegistry.hh"
+#include "Streams.hh"
+#include "Compression.hh"
+#include "Archive.hh"
+#include "TarReader.hh"
 
 
-int main(int argc, char *argv[])
-{
-	n3::useBinaryStreams();
-
-	std::cin.sync_with_stdio(false);
-	std::cout.sync_with_stdio(false);
-	
-	char outputBuffer[1024*1024];
-	std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
-	
-	std::cin.tie(nullptr);
+namespace {
 	
-	n3::CommandLine opt = n3::CommandLine::parse(argc, argv);
+	typedef std::chrono::high_resolution_clock Clock;
 	
-	if (opt.error || opt.help) {
-		std::cerr << "carl version " << CARL_VERSION_STR << std::endl;
-		std::cerr << "\nUsage: carl [-b=base-uri] [-o=output-file] [input-files]" << std::endl;
+	void done(std::uint64_t count, Clock::duration d)
+	{
+		double ms = static_cast<double>(1000 * d.count() * Clock::duration::period::num) / static_cast<double>(Clock::duration::period::den);
 		
-		return opt.error ? -1 : 0;
+		if (count && ms > 0.0) {
+			std::streamsize p = std::cerr.precision();
+			std::cerr << "Done: translated " << count << " triples in " << std::fixed << std::setprecision(1) << ms << std::setprecision(0) << " ms (" << (1000.0 * count / ms) << " triples/s)" << std::setprecision(p) <<  std::endl;
+		} else
+			std::cerr << "Done: translated " << count << " triples" << std::endl;
 	}
 	
-	std::unique_ptr<std::ostream> out;
-	if (opt.output && *opt.output != "-") {
-		out = std::unique_ptr<std::ostream>(new std::ofstream(*opt.output));
+	/// Closes a file descriptor (when not -1) at the end of the scope.
+	struct Closer {
+		int fd;
 		
-		if (!*out) {
-			std::cerr << "error opening \"" << *opt.output << "\"" << std::endl;
+		explicit Closer(int fd) : fd(fd) {}
+		
+		~Closer()
+		{
+			if (fd >= 0)
+				n3::closeFile(fd);
+		}
+	};
+	
+	int run(int argc, char *argv[])
+	{
+		n3::CommandLine opt = n3::CommandLine::parse(argc, argv);
+		
+		if (opt.error || opt.help) {
+			std::cerr << "carl version " << CARL_VERSION_STR << std::endl;
+			std::cerr << "\nUsage: carl [-b=base-uri] [-o=output-file] [--output-format=" << n3::SinkRegistry::formats() << "] [--normalize-numbers] [--typed-values] [--stream-rules] [--pipeline] [--deterministic] [-j=threads] [--read-ahead=size] [--read-ahead-depth=depth] [--max-memory=size] [--stats] [input-files]" << std::endl;
+			std::cerr << "       carl --outdir=directory [--incremental] [--deterministic] [-b=base-uri] [-j=jobs] [-o=output-file] [--max-memory=size] input-files" << std::endl;
+			std::cerr << "       carl --serve=socket [--deterministic] [-b=base-uri] [-j=threads] [--max-request=size] [--idle-timeout=seconds] [--max-memory=size]" << std::endl;
+			std::cerr << "       carl --framed [--deterministic] [-b=base-uri] [--max-request=size] [--max-memory=size]" << std::endl;
+			
+			return opt.error ? -1 : 0;
+		}
+		
+		// accounting costs every allocation a shared counter update, so only when asked for
+		if (opt.maxMemory || opt.stats)
+			n3::Memory::enable();
+		
+		if (opt.maxMemory) {
+			// the startup footprint: the output buffer and the buffers of the lexer and the writer
+			std::size_t footprint = 2 * n3::OUTPUT_BUFFER_SIZE;
+			if (opt.maxMemory < footprint) {
+				std::cerr << "--max-memory must be at least " << footprint << " bytes, the memory carl needs to start" << std::endl;
+				
+				return -1;
+			}
+			
+			n3::Memory::limit(opt.maxMemory);
+		}
+		
+		std::string format = opt.format ? *opt.format : n3::SinkRegistry::DEFAULT_FORMAT;
+		
+		if (!n3::SinkRegistry::contains(format)) {
+			std::cerr << "unknown output format \"" << format << "\", expected one of " << n3::SinkRegistry::formats() << std::endl;
 			
 			return -1;
 		}
-	}
-	
-	n3::TripleSink *s = new n3::CN3Writer(out ? *out : std::cout);
-	
-	std::unique_ptr<n3::TripleSink> sink(s);
-	
-	typedef std::chrono::high_resolution_clock Clock;
-	
-	Clock::time_point start = Clock::now();
-	
-	sink->start();
-	
-	for (std::string input : opt.inputs) {
 		
-		std::string uri;
+		if ((opt.serve || opt.outdir || opt.framed) && format != n3::SinkRegistry::DEFAULT_FORMAT) {
+			std::cerr << "only the " << n3::SinkRegistry::DEFAULT_FORMAT << " output format is supported with --serve, --outdir and --framed" << std::endl;
+			
+			return -1;
+		}
 		
-		std::unique_ptr<std::ifstream> in;
-		if (input != "-") {
-			if (!n3::exists(input)) {
-				std::cerr << "\"" << input << "\" not found" << std::endl;
-				sink->end();
+		if (opt.serve) {
+			n3::Uri base(opt.base ? *opt.base : n3::toUri(".") + "/");
+			n3::Server server(*opt.serve, base, opt.jobs ? opt.jobs : n3::ThreadPool::defaultSize());
+			server.deterministic(opt.deterministic);
+			if (opt.maxRequest)
+				server.maxRequest(opt.maxRequest);
+			if (opt.idleTimeout)
+				server.idleTimeout(*opt.idleTimeout);
+			
+			return server.run();
+		}
+		
+		if (opt.framed) {
+			n3::Uri base(opt.base ? *opt.base : n3::toUri(".") + "/");
+			n3::Translator translator(base);
+			translator.deterministic(opt.deterministic);
+			
+			try {
+				n3::Server::exchange(std::cin, std::cout, translator, opt.maxRequest ? opt.maxRequest : n3::frame::DEFAULT_MAX_REQUEST);
+			} catch (n3::FrameException &e) {
+				std::cerr << "invalid input: " << e.what() << std::endl;
 				
 				return -1;
 			}
 			
-			uri = n3::toUri(input);
-			in = std::unique_ptr<std::ifstream>(new std::ifstream(input, std::ios_base::in | std::ios_base::binary));
-			if (!*in) {
-				std::cerr << "error opening \"" << input << "\"" << std::endl;
-				sink->end();
+			return std::cout ? 0 : -1;
+		}
+		
+		if (opt.outdir) {
+			Clock::time_point start = Clock::now();
+			
+			n3::Batch batch(*opt.outdir, opt.base, opt.jobs ? opt.jobs : 1, opt.incremental);
+			batch.deterministic(opt.deterministic);
+			
+			std::uint64_t count;
+			int status = batch.run(opt.inputs, count);
+			
+			if (status == 0 && opt.output) {
+				if (*opt.output == "-") {
+					status = batch.combine(std::cout) ? 0 : -1;
+				} else {
+					std::unique_ptr<char[]> buffer(new char[n3::OUTPUT_BUFFER_SIZE]);
+					
+					std::ofstream out;
+					out.rdbuf()->pubsetbuf(buffer.get(), n3::OUTPUT_BUFFER_SIZE);
+					out.open(*opt.output, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+					
+					if (!out) {
+						std::cerr << "error opening \"" << *opt.output << "\"" << std::endl;
+						
+						return -1;
+					}
+					
+					status = batch.combine(out) ? 0 : -1;
+				}
+			}
+			
+			if (status == 0)
+				done(count, Clock::now() - start);
+			
+			return status;
+		}
+		
+		// -o file.gz, file.bz2 or file.zst compresses the output, checked before the file is truncated
+		n3::Compression::Format compression = n3::Compression::NONE;
+		if (opt.output && *opt.output != "-") {
+			compression = n3::Compression::fromExtension(*opt.output);
+			if (compression != n3::Compression::NONE && !n3::Compression::supported(compression)) {
+				std::cerr << n3::Compression::name(compression) << " compressed output is not supported by this build" << std::endl;
 				
 				return -1;
 			}
-		} else {
-			uri = "file:///dev/stdin";
 		}
 		
-		std::cerr << "translating " << uri << std::endl;
+		std::unique_ptr<char[]> fileBuffer;
+		std::unique_ptr<std::ofstream> out;
+		if (opt.output && *opt.output != "-") {
+			fileBuffer = std::unique_ptr<char[]>(new char[n3::OUTPUT_BUFFER_SIZE]);
+			out = std::unique_ptr<std::ofstream>(new std::ofstream());
+			out->rdbuf()->pubsetbuf(fileBuffer.get(), n3::OUTPUT_BUFFER_SIZE);
+			out->open(*opt.output, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			
+			if (!*out) {
+				std::cerr << "error opening \"" << *opt.output << "\"" << std::endl;
+				
+				return -1;
+			}
+		}
+		
+		std::unique_ptr<n3::CompressingStreamBuf> compressing;
+		std::unique_ptr<std::ostream> compressed;
+		if (compression != n3::Compression::NONE) {
+			compressing.reset(new n3::CompressingStreamBuf(*out, compression));
+			compressed.reset(new std::ostream(compressing.get()));
+		}
+		
+		n3::SinkOptions options = n3::SinkOptions();
+		options.normalizeNumbers = opt.normalizeNumbers;
+		options.threads = opt.jobs;
+		
+		std::unique_ptr<n3::TripleSink> sink = n3::SinkRegistry::create(format, compressed ? *compressed : out ? *out : std::cout, options);
+		
+		bool readsAhead = opt.readAhead || opt.readAheadDepth;
+		std::size_t readAheadSize = opt.readAhead ? opt.readAhead : n3::ReadAheadStreamBuf::DEFAULT_SIZE;
+		std::size_t readAheadDepth = opt.readAheadDepth ? opt.readAheadDepth : n3::ReadAheadStreamBuf::DEFAULT_DEPTH;
 		
-		n3::Uri baseUri(opt.base ? *opt.base : uri);
+		Clock::time_point start = Clock::now();
 		
-		n3::Parser parser(in ? in.get() : &std::cin, baseUri, sink.get());
-		try {
-			parser.parse();
-		} catch (n3::ParseException &e) {
-			if (e.line() == -1)
-				std::cerr << "parse error: " << e.what() << std::endl;
-			else
-				std::cerr << "parse error at line " << e.line() << ": " << e.what() << std::endl;
+		sink->start();
+		
+		for (std::string input : opt.inputs) {
+			
+			std::string uri;
+			
+			Closer file(-1); // outlives the read-ahead thread reading it
+			std::unique_ptr<n3::ReadAheadStreamBuf> readAhead;
+			std::unique_ptr<std::istream> in;
+			if (input != "-") {
+				if (!n3::exists(input)) {
+					std::cerr << "\"" << input << "\" not found" << std::endl;
+					sink->end();
+					
+					return -1;
+				}
+				
+				uri = n3::toUri(input);
+				if (readsAhead || n3::Compression::detect(input) != n3::Compression::NONE) {
+					file.fd = n3::openFile(input);
+				} else {
+					in.reset(new std::ifstream(input, std::ios_base::in | std::ios_base::binary));
+					if (!*in)
+						in.reset();
+				}
+				
+				if (!in && file.fd < 0) {
+					std::cerr << "error opening \"" << input << "\"" << std::endl;
+					sink->end();
+					
+					return -1;
+				}
+			} else {
+				uri = "file:///dev/stdin";
+				
+				if (readsAhead)
+					file.fd = 0;
+			}
+			
+			if (file.fd >= 0) {
+				try {
+					readAhead.reset(new n3::ReadAheadStreamBuf(n3::Compression::open(file.fd), readAheadSize, readAheadDepth));
+				} catch (n3::InputException &e) {
+					std::cerr << "error reading \"" << input << "\": " << e.what() << std::endl;
+					sink->end();
+					
+					return -1;
+				} catch (std::runtime_error &e) {
+					std::cerr << e.what() << std::endl;
+					sink->end();
+					
+					return -1;
+				}
+				
+				in.reset(new std::istream(readAhead.get()));
+				
+				if (file.fd == 0)
+					file.fd = -1; // stdin stays open
+			}
+			
+			std::cerr << "translating " << uri << std::endl;
+			
+			n3::Uri baseUri(opt.base ? *opt.base : uri);
+			
+			bool archived = n3::TarReader::isArchive(input);
+			
+			// the blank node ids of a document are derived from its contents, stdin is read into memory first
+			n3::Optional<std::uint64_t> contentHash;
+			std::string contents;
+			std::unique_ptr<n3::MemoryStreamBuf> memory;
+			if (opt.deterministic && !archived) {
+				std::uint64_t hash;
+				if (input != "-") {
+					if (!n3::Hash64::file(input, hash)) {
+						std::cerr << "error reading \"" << input << "\"" << std::endl;
+						sink->end();
+						
+						return -1;
+					}
+				} else {
+					std::istream &source = in ? *in : std::cin;
+					contents.assign(std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>());
+					
+					n3::Hash64 h;
+					h.update(contents);
+					hash = h.value();
+					
+					memory.reset(new n3::MemoryStreamBuf(contents.data(), contents.size()));
+					in.reset(new std::istream(memory.get()));
+				}
+				contentHash = hash;
+			}
+			
+			try {
+				if (archived) {
+					n3::Archive archive(sink.get(), opt.jobs ? opt.jobs : 1);
+					if (opt.base)
+						archive.base(*opt.base);
+					archive.typedValues(opt.typedValues);
+					archive.streamFormulas(opt.streamRules);
+					archive.deterministic(opt.deterministic);
+					archive.parse(in ? *in : std::cin, uri);
+				} else if (opt.pipeline) {
+					n3::Pipeline pipeline(sink.get());
+					pipeline.typedValues(opt.typedValues);
+					pipeline.streamFormulas(opt.streamRules);
+					if (contentHash)
+						pipeline.deterministic(*contentHash, opt.base ? uri : std::string());
+					pipeline.parse(in ? in.get() : &std::cin, baseUri);
+				} else {
+					n3::Parser parser(in ? in.get() : &std::cin, baseUri, sink.get());
+					parser.typedValues(opt.typedValues);
+					parser.streamFormulas(opt.streamRules);
+					if (contentHash)
+						parser.deterministic(*contentHash, opt.base ? uri : std::string());
+					parser.parse();
+				}
+			} catch (n3::ParseException &e) {
+				if (!readAhead || readAhead->error().empty()) {
+					std::cerr << e.report() << std::endl;
+					
+					return -1;
+				}
+			} catch (n3::InputException &e) {
+				if (!readAhead || readAhead->error().empty()) {
+					std::cerr << "error reading \"" << input << "\": " << e.what() << std::endl;
+					
+					return -1;
+				}
+			} catch (std::runtime_error &e) {
+				std::cerr << e.what() << std::endl;
+				
+				return -1;
+			}
+			
+			if (readAhead && !readAhead->error().empty()) {
+				std::cerr << "error reading \"" << input << "\": " << readAhead->error() << std::endl;
+				
+				return -1;
+			}
+		}
+		
+		sink->end();
+		
+		if (compressed && !compressed->flush()) {
+			std::cerr << "error writing \"" << *opt.output << "\"" << std::endl;
 			
 			return -1;
 		}
+		
+		done(sink->count(), Clock::now() - start);
+		
+		if (opt.stats) {
+			sink->statistics(std::cerr);
+			n3::Memory::report(std::cerr);
+		}
+		
+		return 0;
 	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	n3::useBinaryStreams();
+
+	std::cin.sync_with_stdio(false);
+	std::cout.sync_with_stdio(false);
 	
-	sink->end();
-	
-	Clock::duration d = Clock::now() - start;
-	
-	double ms = static_cast<double>(1000 * d.count() * Clock::duration::period::num) / static_cast<double>(Clock::duration::period::den);
+	char outputBuffer[n3::OUTPUT_BUFFER_SIZE];
+	std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
 	
-	unsigned count = sink->count();
+	std::cin.tie(nullptr);
 	
-	if (count && ms > 0.0) {
-		std::streamsize p = std::cerr.precision();
-		std::cerr << "Done: translated " << count << " triples in " << std::fixed << std::setprecision(1) << ms << std::setprecision(0) << " ms (" << (1000.0 * count / ms) << " triples/s)" << std::setprecision(p) <<  std::endl;
-	} else
-		std::cerr << "Done: translated " << count << " triples" << std::endl;
+	try {
+		return run(argc, argv);
+	} catch (n3::MemoryLimitExceeded &) {
+		n3::Memory::Unlimited unlimited;
+		std::cerr << "memory limit of " << n3::Memory::limit() << " bytes exceeded" << std::endl;
+	} catch (std::bad_alloc &) {
+		n3::Memory::Unlimited unlimited;
+		std::cerr << "out of memory" << std::endl;
+	}
 	
-	return 0;
-
+	return -1;
 }
@@ -0,0 +1,152 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Manifest.hh"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include "Util.hh"
+
+namespace n3 {
+	
+	namespace {
+		
+		const std::string HEADER    = "carl-manifest 2";
+		const std::string HEADER_V1 = "carl-manifest 1"; // strings are not escaped
+		
+		// strings are written with tabs, line breaks and backslashes as \t, \n, \r and \\ escapes
+		std::string escape(const std::string &s)
+		{
+			std::string result;
+			result.reserve(s.length());
+			
+			for (char c : s) {
+				switch (c) {
+					case '\t': result += "\\t"; break;
+					case '\n': result += "\\n"; break;
+					case '\r': result += "\\r"; break;
+					case '\\': result += "\\\\"; break;
+					default:   result += c;
+				}
+			}
+			
+			return result;
+		}
+		
+		bool unescape(std::string &s)
+		{
+			std::string result;
+			result.reserve(s.length());
+			
+			for (std::size_t i = 0; i < s.length(); i++) {
+				if (s[i] != '\\') {
+					result += s[i];
+					continue;
+				}
+				
+				if (++i == s.length())
+					return false;
+				
+				switch (s[i]) {
+					case 't':  result += '\t'; break;
+					case 'n':  result += '\n'; break;
+					case 'r':  result += '\r'; break;
+					case '\\': result += '\\'; break;
+					default:   return false;
+				}
+			}
+			
+			s.swap(result);
+			
+			return true;
+		}
+	}
+	
+	const std::string Manifest::FILE_NAME(".carl-manifest");
+	
+	// One entry per line, fields separated by tabs, in the order of Manifest::Entry.
+	// The string fields are escaped, so they never contain a tab or a line break.
+	
+	bool Manifest::load(const std::string &path)
+	{
+		m_entries.clear();
+		
+		if (!n3::exists(path))
+			return true;
+		
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		
+		std::string line;
+		if (!std::getline(in, line) || (line != HEADER && line != HEADER_V1))
+			return false;
+		
+		bool escaped = line == HEADER;
+		
+		while (std::getline(in, line)) {
+			std::istringstream fields(line);
+			Entry e;
+			
+			if (!std::getline(fields, e.input, '\t'))
+				return false;
+			
+			fields >> e.size >> e.mtime >> std::hex >> e.hash >> std::dec;
+			fields.ignore(1);
+			
+			if (!std::getline(fields, e.base, '\t') || !std::getline(fields, e.version, '\t'))
+				return false;
+			
+			if (!(fields >> e.count >> e.begin >> e.end >> e.length))
+				return false;
+			
+			if (escaped && !(unescape(e.input) && unescape(e.base) && unescape(e.version)))
+				return false;
+			
+			m_entries[e.input] = e;
+		}
+		
+		return !in.bad();
+	}
+	
+	bool Manifest::save(const std::string &path) const
+	{
+		std::string tmp = path + ".tmp";
+		
+		{
+			std::ofstream out(tmp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			
+			out << HEADER << '\n';
+			for (const auto &i : m_entries) {
+				const Entry &e = i.second;
+				out << escape(e.input) << '\t' << e.size << '\t' << e.mtime << '\t' << std::hex << e.hash << std::dec << '\t'
+				    << escape(e.base) << '\t' << escape(e.version) << '\t' << e.count << '\t' << e.begin << '\t' << e.end << '\t' << e.length << '\n';
+			}
+			
+			if (!out.flush())
+				return false;
+		}
+		
+		// replace the manifest in one step, an interrupted run leaves the old one intact
+#ifdef _WIN32
+		std::remove(path.c_str());
+#endif
+		
+		return std::rename(tmp.c_str(), path.c_str()) == 0;
+	}
+
+}
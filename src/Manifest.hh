@@ -0,0 +1,81 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_MANIFEST_HH
+#define CARL_MANIFEST_HH
+
+#include <cstdint>
+#include <string>
+#include <map>
+
+namespace n3 {
+	
+	///
+	/// Remembers how every input in an output directory was translated,
+	/// so that inputs that did not change are not translated again.
+	///
+	class Manifest {
+	public:
+		
+		struct Entry {
+			std::string input;       // absolute uri of the input
+			std::uint64_t size;      // size of the input
+			std::int64_t mtime;      // modification time of the input, nanoseconds
+			std::uint64_t hash;      // hash of the contents of the input
+			std::string base;        // the base uri used for the translation
+			std::string version;     // the carl version that translated the input
+			std::uint64_t count;     // number of triples
+			std::uint64_t begin;     // start of the body (after the prologue) in the output
+			std::uint64_t end;       // end of the body (start of the epilogue) in the output
+			std::uint64_t length;    // size of the output
+		};
+		
+		static const std::string FILE_NAME;
+		
+	private:
+		
+		std::map<std::string, Entry> m_entries;
+		
+	public:
+		Manifest() : m_entries() {}
+		
+		/// A missing manifest is the same as an empty one, returns false on a corrupt manifest.
+		bool load(const std::string &path);
+		
+		bool save(const std::string &path) const;
+		
+		const Entry *find(const std::string &input) const
+		{
+			auto i = m_entries.find(input);
+			
+			return i == m_entries.end() ? nullptr : &i->second;
+		}
+		
+		void put(const Entry &entry)
+		{
+			m_entries[entry.input] = entry;
+		}
+		
+		void remove(const std::string &input)
+		{
+			m_entries.erase(input);
+		}
+	};
+
+}
+
+#endif /* CARL_MANIFEST_HH */
@@ -0,0 +1,249 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Memory.hh"
+
+#include <atomic>
+#include <cstdlib>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		const char *const KIND_NAMES[] = {
+			"uris", "blank nodes", "literals", "booleans", "integers", "doubles", "decimals", "strings", "lists", "vars", "formulas"
+		};
+		
+		struct Counter {
+			std::atomic<std::size_t> live;
+			std::atomic<std::size_t> peak;
+			
+			void add(std::size_t size)
+			{
+				std::size_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+				std::size_t max = peak.load(std::memory_order_relaxed);
+				while (now > max && !peak.compare_exchange_weak(max, now, std::memory_order_relaxed))
+					;
+			}
+			
+			void subtract(std::size_t size)
+			{
+				live.fetch_sub(size, std::memory_order_relaxed);
+			}
+		};
+		
+		// zero initialized before any dynamic initialization, so usable by operator new at any time
+		Counter total;
+		Counter kinds[Memory::KINDS];
+		std::atomic<std::size_t> maximum;
+		std::atomic<bool> accounting; // only read after enable(), before the threads start
+		thread_local unsigned unlimited;
+	}
+	
+	void Memory::enable()
+	{
+		accounting.store(true, std::memory_order_relaxed);
+	}
+	
+	bool Memory::enabled()
+	{
+		return accounting.load(std::memory_order_relaxed);
+	}
+	
+	std::size_t Memory::live()
+	{
+		return total.live.load(std::memory_order_relaxed);
+	}
+	
+	std::size_t Memory::peak()
+	{
+		return total.peak.load(std::memory_order_relaxed);
+	}
+	
+	std::size_t Memory::live(Kind kind)
+	{
+		return kinds[kind].live.load(std::memory_order_relaxed);
+	}
+	
+	std::size_t Memory::peak(Kind kind)
+	{
+		return kinds[kind].peak.load(std::memory_order_relaxed);
+	}
+	
+	void Memory::limit(std::size_t bytes)
+	{
+		maximum.store(bytes, std::memory_order_relaxed);
+	}
+	
+	std::size_t Memory::limit()
+	{
+		return maximum.load(std::memory_order_relaxed);
+	}
+	
+	void *Memory::allocate(std::size_t size, Kind kind)
+	{
+		void *p = ::operator new(size);
+		if (enabled())
+			kinds[kind].add(size);
+		
+		return p;
+	}
+	
+	void Memory::deallocate(void *p, std::size_t size, Kind kind) noexcept
+	{
+		if (enabled())
+			kinds[kind].subtract(size);
+		::operator delete(p);
+	}
+	
+	void Memory::report(std::ostream &out)
+	{
+		out << "memory: " << live() << " bytes live, " << peak() << " bytes peak" << std::endl;
+		out << " node objects, without the strings they own:" << std::endl;
+		for (int kind = 0; kind < KINDS; kind++) {
+			if (peak(static_cast<Kind>(kind)) != 0)
+				out << "  " << KIND_NAMES[kind] << ": " << live(static_cast<Kind>(kind)) << " bytes live, " << peak(static_cast<Kind>(kind)) << " bytes peak" << std::endl;
+		}
+	}
+	
+	Memory::Unlimited::Unlimited()
+	{
+		++unlimited;
+	}
+	
+	Memory::Unlimited::~Unlimited()
+	{
+		--unlimited;
+	}
+
+}
+
+#ifndef CARL_NO_MEMORY_ACCOUNTING
+
+namespace {
+	
+	// every block starts with its size, keeping the alignment of malloc, or with
+	// UNACCOUNTED when it was allocated before accounting was enabled
+	const std::size_t HEADER = alignof(std::max_align_t);
+	const std::size_t UNACCOUNTED = static_cast<std::size_t>(-1);
+	
+	bool exceedsLimit(std::size_t size) noexcept
+	{
+		std::size_t max = n3::maximum.load(std::memory_order_relaxed);
+		
+		return max != 0 && n3::total.live.load(std::memory_order_relaxed) + size > max && n3::unlimited == 0;
+	}
+	
+	void *allocateBlock(std::size_t size) noexcept
+	{
+		if (size > UNACCOUNTED - HEADER)
+			return nullptr;
+		
+		char *p = static_cast<char *>(std::malloc(size + HEADER));
+		if (!p)
+			return nullptr;
+		
+		if (n3::Memory::enabled()) {
+			*reinterpret_cast<std::size_t *>(p) = size;
+			n3::total.add(size);
+		} else {
+			*reinterpret_cast<std::size_t *>(p) = UNACCOUNTED;
+		}
+		
+		return p + HEADER;
+	}
+	
+	void deallocate(void *p) noexcept
+	{
+		if (!p)
+			return;
+		
+		char *block = static_cast<char *>(p) - HEADER;
+		std::size_t size = *reinterpret_cast<std::size_t *>(block);
+		if (size != UNACCOUNTED)
+			n3::total.subtract(size);
+		std::free(block);
+	}
+	
+	void *allocate(std::size_t size)
+	{
+		if (exceedsLimit(size))
+			throw n3::MemoryLimitExceeded();
+		
+		void *p;
+		while (!(p = allocateBlock(size))) {
+			std::new_handler handler = std::get_new_handler();
+			if (!handler)
+				throw std::bad_alloc();
+			handler();
+		}
+		
+		return p;
+	}
+	
+	void *allocate(std::size_t size, const std::nothrow_t &) noexcept
+	{
+		try {
+			return allocate(size);
+		} catch (std::bad_alloc &) {
+			return nullptr;
+		}
+	}
+}
+
+void *operator new(std::size_t size)
+{
+	return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+	return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &nothrow) noexcept
+{
+	return allocate(size, nothrow);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &nothrow) noexcept
+{
+	return allocate(size, nothrow);
+}
+
+void operator delete(void *p) noexcept
+{
+	deallocate(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	deallocate(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+	deallocate(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+	deallocate(p);
+}
+
+#endif /* CARL_NO_MEMORY_ACCOUNTING */
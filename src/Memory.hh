@@ -0,0 +1,88 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_MEMORY_HH
+#define CARL_MEMORY_HH
+
+#include <cstddef>
+#include <new>
+#include <ostream>
+
+namespace n3 {
+	
+	///
+	/// Thrown by operator new when an allocation would exceed Memory::limit().
+	///
+	class MemoryLimitExceeded : public std::bad_alloc {
+	public:
+		const char *what() const noexcept override { return "memory limit exceeded"; }
+	};
+	
+	///
+	/// Allocation accounting. The global operator new and delete are replaced to keep the number
+	/// of bytes live and the peak, unless CARL_NO_MEMORY_ACCOUNTING is defined. Nodes are also
+	/// accounted per kind, counting the node objects themselves, not the strings they own.
+	///
+	/// Nothing is counted until enable() is called: the shared counters would otherwise be
+	/// updated by every allocation on every thread.
+	///
+	class Memory {
+	public:
+		
+		enum Kind { URI, BLANK_NODE, LITERAL, BOOLEAN, INTEGER, DOUBLE, DECIMAL, STRING, LIST, VAR, FORMULA, KINDS };
+		
+		/// Starts accounting the allocations made from now on. Call once, before any
+		/// thread is started or node is allocated.
+		static void enable();
+		static bool enabled();
+		
+		static std::size_t live();
+		static std::size_t peak();
+		static std::size_t live(Kind kind);
+		static std::size_t peak(Kind kind);
+		
+		/// Allocations that would make live() exceed bytes throw MemoryLimitExceeded, 0 means no limit.
+		static void limit(std::size_t bytes);
+		static std::size_t limit();
+		
+		static void *allocate(std::size_t size, Kind kind);
+		static void deallocate(void *p, std::size_t size, Kind kind) noexcept;
+		
+		/// Writes live and peak bytes, in total and per kind of node.
+		static void report(std::ostream &out);
+		
+		///
+		/// Lifts the limit for the current thread while in scope, to report that it was exceeded.
+		///
+		class Unlimited {
+		public:
+			Unlimited();
+			~Unlimited();
+			
+			Unlimited(const Unlimited &) = delete;
+			Unlimited &operator=(const Unlimited &) = delete;
+		};
+	};
+
+}
+
+/// Accounts the allocations of a node class as kind, see Memory.
+#define CARL_NODE_ALLOCATION(kind) \
+	static void *operator new(std::size_t size) { return ::n3::Memory::allocate(size, ::n3::Memory::kind); } \
+	static void operator delete(void *p, std::size_t size) noexcept { ::n3::Memory::deallocate(p, size, ::n3::Memory::kind); }
+
+#endif /* CARL_MEMORY_HH */
@@ -18,11 +18,16 @@
 #define CARL_MODEL_HH
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <ostream>
 #include <vector>
 #include <utility>
 
+#include "Datatypes.hh"
+#include "Memory.hh"
+
 namespace n3 {
 
 	class URIResource;
@@ -86,6 +91,8 @@ namespace n3 {
 	class URIResource : public Resource {
 		std::string m_uri;
 	public:
+		CARL_NODE_ALLOCATION(URI)
+		
 		explicit URIResource(const std::string &uri) : Resource(), m_uri(uri) {}
 		explicit URIResource(std::string &&uri)      : Resource(), m_uri(std::move(uri)) {}
 		
@@ -119,6 +126,8 @@ namespace n3 {
 	class BlankNode : public Resource {
 		std::string m_id;
 	public:
+		CARL_NODE_ALLOCATION(BLANK_NODE)
+		
 		explicit BlankNode(const std::string &id) : Resource(), m_id(id) {}
 		explicit BlankNode(std::string &&id)      : Resource(), m_id(std::move(id)) {}
 		
@@ -148,23 +157,48 @@ namespace n3 {
 	};
 	
 
-	class RDFList : public N3Node {
-		std::vector<N3Node *> m_elements;
+	class RDFList : public N3Node { /* copies share the elements until one of them is modified */
+		
+		struct Elements {
+			std::vector<N3Node *> nodes;
+			
+			Elements() : nodes() {}
+			Elements(const Elements &) = delete;
+			Elements &operator=(const Elements &) = delete;
+			
+			~Elements()
+			{
+				for (N3Node *n : nodes)
+					delete n;
+			}
+		};
+		
+		std::shared_ptr<Elements> m_elements;
 		
-		typedef std::vector<N3Node *>::iterator iterator;
 		typedef std::vector<N3Node *>::const_iterator const_iterator;
 		
 	public:
-		RDFList() : N3Node(), m_elements() {}
-		
-		RDFList(const RDFList &list) : RDFList()
-		{
-			m_elements.reserve(list.m_elements.size());
-			for (N3Node *n : list.m_elements) {
-				m_elements.push_back(n->clone());
+		CARL_NODE_ALLOCATION(LIST)
+		
+		/// Makes the elements unshared and returns them for modification; all other access is read-only,
+		/// so reading a shared list never copies it.
+		std::vector<N3Node *> &mutableElements()
+		{
+			if (m_elements.use_count() > 1) {
+				std::shared_ptr<Elements> copy = std::make_shared<Elements>();
+				copy->nodes.reserve(m_elements->nodes.size());
+				for (N3Node *n : m_elements->nodes)
+					copy->nodes.push_back(n->clone());
+				m_elements = std::move(copy);
 			}
+			
+			return m_elements->nodes;
 		}
 		
+		RDFList() : N3Node(), m_elements(std::make_shared<Elements>()) {}
+		
+		RDFList(const RDFList &list) = default;
+		
 		RDFList(RDFList &&list) : RDFList()
 		{
 			m_elements.swap(list.m_elements);
@@ -184,62 +218,41 @@ namespace n3 {
 			return *this;
 		}
 		
-		~RDFList()
-		{
-			for (N3Node *n : m_elements)
-				delete n;
-		}
-		
 		void add(N3Node *element)
 		{
-			m_elements.push_back(element);
+			mutableElements().push_back(element);
 		}
 		
-		N3Node *&operator[](std::size_t index)
-		{
-			return m_elements[index];
-		}
-
 		N3Node * const &operator[](std::size_t index) const
 		{
-			return m_elements[index];
+			return m_elements->nodes[index];
 		}
 		
 		std::size_t size() const
 		{
-			return m_elements.size();
-		}
-		
-		iterator begin()
-		{
-			return m_elements.begin();
-		}
-		
-		iterator end()
-		{
-			return m_elements.end();
+			return m_elements->nodes.size();
 		}
 		
 		const_iterator begin() const
 		{
-			return m_elements.begin();
+			return m_elements->nodes.begin();
 		}
 		
 		const_iterator end() const
 		{
-			return m_elements.end();
+			return m_elements->nodes.end();
 		}
 		
 		bool empty() const
 		{
-			return m_elements.empty();
+			return m_elements->nodes.empty();
 		}
 		
 		std::ostream &print(std::ostream &out) const override
 		{
 			out << '(';
 			
-			for (N3Node *n : m_elements)
+			for (const N3Node *n : *this)
 				out << ' ' << *n;
 			
 			out << ')';
@@ -291,6 +304,8 @@ namespace n3 {
 	
 	class BooleanLiteral : public Literal {
 	public:
+		CARL_NODE_ALLOCATION(BOOLEAN)
+		
 		explicit BooleanLiteral(const std::string &value) : Literal(value, &TYPE) {}
 		
 		static const std::string TYPE;
@@ -321,10 +336,23 @@ namespace n3 {
 	};
 
 	class IntegerLiteral : public Literal {
+		
+		bool m_native;
+		std::int64_t m_value;
+		
 	public:
+		CARL_NODE_ALLOCATION(INTEGER)
+		
 		static const std::string TYPE;
 		
-		explicit IntegerLiteral(const std::string &value) : Literal(value, &TYPE) {}
+		explicit IntegerLiteral(const std::string &value) : Literal(value, &TYPE), m_native(false), m_value(0) {}
+		
+		/// An integer with its parsed value, see hasValue().
+		IntegerLiteral(const std::string &lexical, std::int64_t value) : Literal(lexical, &TYPE), m_native(true), m_value(value) {}
+		
+		/// True when the literal was parsed and fits an int64_t, otherwise only the lexical form is known.
+		bool hasValue() const { return m_native; }
+		std::int64_t value() const { return m_value; }
 		
 		std::ostream &print(std::ostream &out) const override
 		{
@@ -335,7 +363,7 @@ namespace n3 {
 		
 		IntegerLiteral *clone() const override
 		{
-			return new IntegerLiteral(m_lexical);
+			return new IntegerLiteral(*this);
 		}
 		
 		void visit(N3NodeVisitor &visitor) const override
@@ -345,10 +373,20 @@ namespace n3 {
 	};
 
 	class DoubleLiteral : public Literal {
+		
+		bool m_native;
+		double m_value;
+		
 	public:
+		CARL_NODE_ALLOCATION(DOUBLE)
+		
 		static const std::string TYPE;
 		
-		explicit DoubleLiteral(const std::string &value) : Literal(value, &TYPE) {}
+		explicit DoubleLiteral(const std::string &value) : Literal(value, &TYPE), m_native(false), m_value(0) {}
+		DoubleLiteral(const std::string &lexical, double value) : Literal(lexical, &TYPE), m_native(true), m_value(value) {}
+		
+		bool hasValue() const { return m_native; }
+		double value() const { return m_value; }
 		
 		std::ostream &print(std::ostream &out) const override
 		{
@@ -359,7 +397,7 @@ namespace n3 {
 		
 		DoubleLiteral *clone() const override
 		{
-			return new DoubleLiteral(m_lexical);
+			return new DoubleLiteral(*this);
 		}
 		
 		void visit(N3NodeVisitor &visitor) const override
@@ -369,10 +407,24 @@ namespace n3 {
 	};
 
 	class DecimalLiteral : public Literal {
+		
+		bool m_native;
+		unsigned m_scale;
+		std::int64_t m_unscaled;
+		
 	public:
+		CARL_NODE_ALLOCATION(DECIMAL)
+		
 		static const std::string TYPE;
 		
-		explicit DecimalLiteral(const std::string &value) : Literal(value, &TYPE) {}
+		explicit DecimalLiteral(const std::string &value) : Literal(value, &TYPE), m_native(false), m_scale(0), m_unscaled(0) {}
+		
+		/// A decimal with the value unscaled / 10^scale.
+		DecimalLiteral(const std::string &lexical, std::int64_t unscaled, unsigned scale) : Literal(lexical, &TYPE), m_native(true), m_scale(scale), m_unscaled(unscaled) {}
+		
+		bool hasValue() const { return m_native; }
+		std::int64_t unscaled() const { return m_unscaled; }
+		unsigned scale() const { return m_scale; }
 		
 		std::ostream &print(std::ostream &out) const override
 		{
@@ -383,7 +435,7 @@ namespace n3 {
 		
 		DecimalLiteral *clone() const override
 		{
-			return new DecimalLiteral(m_lexical);
+			return new DecimalLiteral(*this);
 		}
 		
 		void visit(N3NodeVisitor &visitor) const override
@@ -397,6 +449,8 @@ namespace n3 {
 		std::string m_language;
 
 	public:
+		CARL_NODE_ALLOCATION(STRING)
+		
 		static const std::string TYPE;
 		
 		explicit StringLiteral(const std::string &value, const std::string &language = std::string()) : Literal(value, &TYPE), m_language(language) {}
@@ -425,45 +479,20 @@ namespace n3 {
 		}
 	};
 	
-	class OtherLiteral : public Literal { /* keeps a copy of the type uri */
+	class OtherLiteral : public Literal { /* points to an interned type uri, see Datatypes */
 		
-		std::string m_datatype_copy;
+		std::shared_ptr<const std::string> m_owned; // the type uri when it is not interned
 		
 	public:
+		CARL_NODE_ALLOCATION(LITERAL)
 		
-		explicit OtherLiteral(const std::string &value, const std::string &datatype) : Literal(value, nullptr), m_datatype_copy(datatype)
-		{
-			m_datatype = &m_datatype_copy;
-		}
-		
-		explicit OtherLiteral(std::string &&value, std::string &&datatype) noexcept : Literal(std::move(value), nullptr), m_datatype_copy(std::move(datatype))
-		{
-			m_datatype = &m_datatype_copy;
-		}
-		
-		OtherLiteral(const OtherLiteral &other) : Literal(other.m_lexical, nullptr), m_datatype_copy(other.m_datatype_copy)
-		{
-			m_datatype = &m_datatype_copy;
-		}
 		
-		OtherLiteral(OtherLiteral &&other) noexcept : Literal(std::move(other.m_lexical), nullptr), m_datatype_copy(std::move(other.m_datatype_copy))
-		{
-			m_datatype = &m_datatype_copy;
-		}
+		explicit OtherLiteral(const std::string &value, const std::string &datatype) : OtherLiteral(std::string(value), Datatypes::intern(datatype)) {}
 		
-		OtherLiteral& operator=(OtherLiteral other)
-		{
-			swap(other);
-			
-			return *this;
-		}
+		explicit OtherLiteral(std::string &&value, const std::string &datatype) : OtherLiteral(std::move(value), Datatypes::intern(datatype)) {}
 		
-		OtherLiteral& operator=(OtherLiteral &&other) noexcept
-		{
-			swap(other);
-			
-			return *this;
-		}
+		/// A literal with an already interned datatype.
+		OtherLiteral(std::string &&value, const Datatypes::Entry &datatype) noexcept : Literal(std::move(value), datatype.iri), m_owned(datatype.owned) {}
 		
 		std::ostream &print(std::ostream &out) const override
 		{
@@ -474,22 +503,9 @@ namespace n3 {
 		
 		OtherLiteral *clone() const override
 		{
-			return new OtherLiteral(m_lexical, m_datatype_copy);
-		}
-
-		void swap(OtherLiteral &other) noexcept
-		{
-			m_lexical.swap(other.m_lexical);
-			m_datatype_copy.swap(other.m_datatype_copy);
-
-//			m_datatype = &m_datatype_copy;
+			return new OtherLiteral(*this);
 		}
 	};
-	
-	inline void swap(OtherLiteral &x, OtherLiteral &y) noexcept
-	{
-		x.swap(y);
-	}
 
 
 
@@ -498,6 +514,8 @@ namespace n3 {
 		std::string m_name;
 
 	public:
+		CARL_NODE_ALLOCATION(VAR)
+		
 		explicit Var(const std::string &name) : m_name(name) {}
 		explicit Var(std::string &&name) : m_name(std::move(name)) {}
 
@@ -527,11 +545,11 @@ namespace n3 {
 	};
 
 
-	class TriplePattern {
+	class TriplePattern { /* move-only, owns its nodes */
 		
-		N3Node *m_subject;
-		N3Node *m_property;
-		N3Node *m_object;
+		std::unique_ptr<N3Node> m_subject;
+		std::unique_ptr<N3Node> m_property;
+		std::unique_ptr<N3Node> m_object;
 
 	public:
 
@@ -540,36 +558,28 @@ namespace n3 {
 		{
 		}
 		
-		TriplePattern(const TriplePattern &pattern)
-			: m_subject(pattern.m_subject->clone()), m_property(pattern.m_property->clone()), m_object(pattern.m_object->clone())
+		TriplePattern(std::unique_ptr<N3Node> subject, std::unique_ptr<N3Node> property, std::unique_ptr<N3Node> object) noexcept
+			: m_subject(std::move(subject)), m_property(std::move(property)), m_object(std::move(object))
 		{
 		}
 		
-		TriplePattern(TriplePattern &&pattern)
-			: m_subject(), m_property(), m_object()
-		{
-			swap(pattern);
-		}
+		TriplePattern(const TriplePattern &pattern) = delete;
+		TriplePattern &operator=(const TriplePattern &pattern) = delete;
 		
-		TriplePattern &operator=(TriplePattern pattern)
-		{
-			swap(pattern);
-			
-			return *this;
-		}
+		TriplePattern(TriplePattern &&pattern) noexcept = default;
+		TriplePattern &operator=(TriplePattern &&pattern) noexcept = default;
 		
-		TriplePattern &operator=(TriplePattern &&pattern) noexcept
+		/// A deep copy.
+		TriplePattern clone() const
 		{
-			swap(pattern);
-			
-			return *this;
+			return TriplePattern(*m_subject, *m_property, *m_object);
 		}
 
 		void swap(TriplePattern &other) noexcept
 		{
-			std::swap(m_subject, other.m_subject);
-			std::swap(m_property, other.m_property);
-			std::swap(m_object, other.m_object);
+			m_subject.swap(other.m_subject);
+			m_property.swap(other.m_property);
+			m_object.swap(other.m_object);
 		}
 		
 		const N3Node &subject() const noexcept
@@ -587,52 +597,56 @@ namespace n3 {
 			return *m_object;
 		}
 		
-		void subject(const N3Node &subject)
-		{
-			m_subject = subject.clone();
-		}
-		
-		void property(const N3Node &property)
+		void subject(std::unique_ptr<N3Node> subject) noexcept
 		{
-			m_property = property.clone();
+			m_subject = std::move(subject);
 		}
 		
-		void object(const N3Node &object)
+		void property(std::unique_ptr<N3Node> property) noexcept
 		{
-			m_object = object.clone();
+			m_property = std::move(property);
 		}
 		
-		~TriplePattern()
+		void object(std::unique_ptr<N3Node> object) noexcept
 		{
-			delete m_subject;
-			delete m_property;
-			delete m_object;
+			m_object = std::move(object);
 		}
 	};
 
-	class GraphTemplate : public N3Node {
+	class GraphTemplate : public N3Node { /* copies share the triples until one of them is modified */
 		
 		std::string m_id;
 
-		std::vector<TriplePattern> m_triples;
+		std::shared_ptr<std::vector<TriplePattern>> m_triples;
 		
 	public:
-
-		typedef std::vector<TriplePattern>::iterator iterator;
+		CARL_NODE_ALLOCATION(FORMULA)
+		
+		/// Makes the triples unshared and returns them for modification; all other access is read-only,
+		/// so reading a shared formula never copies it.
+		std::vector<TriplePattern> &mutableTriples()
+		{
+			if (m_triples.use_count() > 1) {
+				std::shared_ptr<std::vector<TriplePattern>> copy = std::make_shared<std::vector<TriplePattern>>();
+				copy->reserve(m_triples->size());
+				for (const TriplePattern &t : *m_triples)
+					copy->push_back(t.clone());
+				m_triples = std::move(copy);
+			}
+			
+			return *m_triples;
+		}
+		
 		typedef std::vector<TriplePattern>::const_iterator const_iterator;
 		
-		typedef std::vector<TriplePattern>::reference reference;
 		typedef std::vector<TriplePattern>::const_reference const_reference;
 
-		explicit GraphTemplate(const std::string &id) : m_id(id), m_triples() {}
-		explicit GraphTemplate(std::string &&id) : m_id(std::move(id)), m_triples() {}
+		explicit GraphTemplate(const std::string &id) : m_id(id), m_triples(std::make_shared<std::vector<TriplePattern>>()) {}
+		explicit GraphTemplate(std::string &&id) : m_id(std::move(id)), m_triples(std::make_shared<std::vector<TriplePattern>>()) {}
 		
+		GraphTemplate(const GraphTemplate &graph) = default;
 		
-		GraphTemplate(const GraphTemplate &graph) : m_id(graph.m_id), m_triples(graph.m_triples)
-		{
-		}
-		
-		GraphTemplate(GraphTemplate &&graph) : m_id(std::move(graph.m_id)), m_triples()
+		GraphTemplate(GraphTemplate &&graph) : m_id(std::move(graph.m_id)), m_triples(std::make_shared<std::vector<TriplePattern>>())
 		{
 			m_triples.swap(graph.m_triples);
 		}
@@ -664,64 +678,58 @@ namespace n3 {
 		
 		void triple(const N3Node &subject, const Resource &property, const N3Node &object)
 		{
-			m_triples.push_back(TriplePattern(subject, property, object));
+			mutableTriples().push_back(TriplePattern(subject, property, object));
 		}
 		
 		void triple(const N3Node &subject, const Var &property, const N3Node &object)
 		{
-			m_triples.push_back(TriplePattern(subject, property, object));
+			mutableTriples().push_back(TriplePattern(subject, property, object));
 		}
-
-		const std::string &id() const { return m_id; }
-
-		std::size_t size() const
+		
+		/// Adds a triple, taking ownership of its nodes.
+		void triple(std::unique_ptr<N3Node> subject, std::unique_ptr<N3Node> property, std::unique_ptr<N3Node> object)
 		{
-				return m_triples.size();
+			mutableTriples().emplace_back(std::move(subject), std::move(property), std::move(object));
 		}
 
-		iterator begin()
-		{
-			return m_triples.begin();
-		}
+		const std::string &id() const { return m_id; }
 
-		iterator end()
+		std::size_t size() const
 		{
-			return m_triples.end();
+				return m_triples->size();
 		}
 
 		const_iterator begin() const
 		{
-			return m_triples.begin();
+			return m_triples->begin();
 		}
 
 		const_iterator end() const
 		{
-			return m_triples.end();
+			return m_triples->end();
 		}
 
 		bool empty() const
 		{
-			return m_triples.empty();
+			return m_triples->empty();
 		}
 		
-		reference front()
+		void clear()
 		{
-			return m_triples.front();
+			if (m_triples.use_count() > 1)
+				m_triples = std::make_shared<std::vector<TriplePattern>>();
+			else
+				m_triples->clear();
 		}
 		
 		const_reference front() const
 		{
-			return m_triples.front();
-		}
-		
-		reference back()
-		{
-			return m_triples.back();
+			return m_triples->front();
 		}
 		
 		const_reference back() const
 		{
-			return m_triples.back();
+			return m_triples->back();
 		}
 		
 		GraphTemplate *clone() const override
@@ -729,15 +737,15 @@ namespace n3 {
 			return new GraphTemplate(*this);
 		}
 		
-		reference operator[](std::size_t pos)
+		const_reference operator[](std::size_t pos) const
 		{
-			return m_triples[pos];
+			return (*m_triples)[pos];
 		}
 		
 		std::ostream &print(std::ostream &out) const override
 		{
 			out.put('{').put('\n');
-			for (const TriplePattern &t : m_triples) {
+			for (const TriplePattern &t : *m_triples) {
 				out.put('\t');
 				t.subject().print(out);
 				out.put(' ');
@@ -0,0 +1,268 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "NTriplesWriter.hh"
+
+#include "CN3Writer.hh"
+#include "Utf8.hh"
+
+
+namespace n3 {
+	
+	// For every byte: 0 when it is written as is, the letter of its ECHAR,
+	// 'u' when it is written as UCHAR or 'x' for the start of a multibyte UTF-8 sequence.
+	
+	alignas(256) const char NTriplesWriter::LITERAL_ESCAPE[] = {
+		'u','u','u','u','u','u','u','u','b','t','n','u','f','r','u','u',  'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u', // 0x00 - 0x1F
+		  0,  0,'"',  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // 0x20 - 0x3F
+		  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'\\',  0,  0,  0, // 0x40 - 0x5F
+		  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'u', // 0x60 - 0x7F
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0x80 - 0x9F
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0xA0 - 0xBF
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0xC0 - 0xDF
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x'  // 0xE0 - 0xFF
+	};
+	
+	alignas(256) const char NTriplesWriter::IRI_ESCAPE[] = {
+		'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u',  'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u', // 0x00 - 0x1F
+		'u',  0,'u',  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'u',  0,'u',  0, // 0x20 - 0x3F
+		  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'u',  0,'u',  0, // 0x40 - 0x5F
+		'u',  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'u','u','u',  0,'u', // 0x60 - 0x7F
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0x80 - 0x9F
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0xA0 - 0xBF
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x', // 0xC0 - 0xDF
+		'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x',  'x','x','x','x','x','x','x','x','x','x','x','x','x','x','x','x'  // 0xE0 - 0xFF
+	};
+	
+	void NTriplesWriter::writeUchar(char c)
+	{
+		m_outbuf->sputn("\\u00", 4);
+		m_outbuf->sputc(N3PFormatter::HEX_CHAR[(c & 0xF0) >> 4]);
+		m_outbuf->sputc(N3PFormatter::HEX_CHAR[c & 0x0F]);
+	}
+	
+	void NTriplesWriter::write(const std::string &s, const char *escape)
+	{
+		const char REPLACEMENT_CHARACTER[] = "\xEF\xBF\xBD";
+		
+		const char *p     = s.data();
+		const char *end   = p + s.length();
+		const char *start = p; // start of the bytes not yet written
+		
+		while (p < end) {
+			char e = escape[static_cast<unsigned char>(*p)];
+			
+			if (!e) {
+				++p;
+			} else if (e == 'x') {
+				char32_t c;
+				utf8::State state;
+				int r = utf8::decode(&c, p, end, &state);
+				
+				if (r > 0) {
+					p += r;
+				} else {
+					m_outbuf->sputn(start, p - start);
+					m_outbuf->sputn(REPLACEMENT_CHARACTER, 3);
+					p = r == -1 ? p + 1 : end;
+					start = p;
+				}
+			} else {
+				m_outbuf->sputn(start, p - start);
+				
+				if (e == 'u') {
+					writeUchar(*p);
+				} else {
+					m_outbuf->sputc('\\');
+					m_outbuf->sputc(e);
+				}
+				
+				start = ++p;
+			}
+		}
+		
+		m_outbuf->sputn(start, p - start);
+	}
+	
+	void NTriplesWriter::writeSkolem(const std::string &id)
+	{
+		m_outbuf->sputc('<');
+		m_outbuf->sputn(N3PFormatter::SKOLEM_PREFIX.c_str(), N3PFormatter::SKOLEM_PREFIX.length());
+		write(id, IRI_ESCAPE);
+		m_outbuf->sputc('>');
+	}
+	
+	void NTriplesWriter::visit(const URIResource &resource)
+	{
+		writeIri(resource.uri());
+	}
+	
+	void NTriplesWriter::visit(const BlankNode &blankNode)
+	{
+		if (m_graph)
+			writeSkolem(blankNode.id() + '_' + m_graph->id());
+		else
+			writeSkolem(blankNode.id());
+	}
+	
+	void NTriplesWriter::visit(const Literal &literal)
+	{
+		writeLiteral(literal.lexical(), literal.datatype());
+	}
+	
+	void NTriplesWriter::visit(const BooleanLiteral &literal)
+	{
+		const std::string &lexical = literal.value() ? BooleanLiteral::VALUE_TRUE.lexical() : BooleanLiteral::VALUE_FALSE.lexical();
+		
+		writeLiteral(lexical, BooleanLiteral::TYPE);
+	}
+	
+	void NTriplesWriter::visit(const IntegerLiteral &literal)
+	{
+		writeNumber(literal.lexical(), IntegerLiteral::TYPE, NumberFormat::writeCanonicalInteger);
+	}
+	
+	void NTriplesWriter::visit(const DoubleLiteral &literal)
+	{
+		writeNumber(literal.lexical(), DoubleLiteral::TYPE, NumberFormat::writeCanonicalDouble);
+	}
+	
+	void NTriplesWriter::visit(const DecimalLiteral &literal)
+	{
+		writeNumber(literal.lexical(), DecimalLiteral::TYPE, NumberFormat::writeCanonicalDecimal);
+	}
+	
+	void NTriplesWriter::visit(const StringLiteral &literal)
+	{
+		m_outbuf->sputc('"');
+		write(literal.lexical(), LITERAL_ESCAPE);
+		m_outbuf->sputc('"');
+		
+		const std::string &lang = literal.language();
+		if (!lang.empty()) {
+			m_outbuf->sputc('@');
+			m_outbuf->sputn(lang.c_str(), lang.length());
+		}
+	}
+	
+	void NTriplesWriter::visit(const RDFList &list)
+	{
+		if (list.empty()) {
+			writeIri(RDF::nil.uri());
+		} else {
+			m_pending.push_back(Pending { &list, m_ids.generate(), m_graph });
+			writeSkolem(m_pending.back().iri);
+		}
+	}
+	
+	void NTriplesWriter::visit(const GraphTemplate &graph)
+	{
+		std::string id = m_ids.generate("g" + graph.id());
+		
+		writeSkolem(id);
+		
+		if (m_quads && !graph.empty())
+			m_pending.push_back(Pending { &graph, std::move(id), m_graph });
+	}
+	
+	void NTriplesWriter::visit(const Var &var)
+	{
+		writeSkolem(m_ids.generate("v" + var.name()));
+	}
+	
+	void NTriplesWriter::endLine()
+	{
+		if (m_graph) {
+			m_outbuf->sputc(' ');
+			writeSkolem(m_graphId);
+		}
+		
+		m_outbuf->sputc(' ');
+		m_outbuf->sputc('.');
+		m_outbuf->sputc('\n');
+		
+		++m_count;
+	}
+	
+	void NTriplesWriter::writeLine(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		subject.visit(*this);
+		m_outbuf->sputc(' ');
+		property.visit(*this);
+		m_outbuf->sputc(' ');
+		object.visit(*this);
+		endLine();
+	}
+	
+	void NTriplesWriter::writeLine(const std::string &subject, const URIResource &property, const N3Node &object)
+	{
+		writeSkolem(subject);
+		m_outbuf->sputc(' ');
+		writeIri(property.uri());
+		m_outbuf->sputc(' ');
+		object.visit(*this);
+		endLine();
+	}
+	
+	void NTriplesWriter::triple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		enterGraph(nullptr);
+		
+		writeLine(subject, property, object);
+		
+		// lists and graphs add to m_pending while it is processed
+		for (std::size_t i = 0; i < m_pending.size(); i++) {
+			const N3Node *node = m_pending[i].node;
+			
+			if (node->isRDFList()) {
+				const RDFList &list = static_cast<const RDFList &>(*node);
+				
+				enterGraph(m_pending[i].graph);
+				
+				std::string cell = m_pending[i].iri;
+				for (std::size_t j = 0; j < list.size(); j++) {
+					writeLine(cell, RDF::first, *list[j]);
+					
+					if (j + 1 < list.size()) {
+						std::string next = m_ids.generate();
+						
+						writeSkolem(cell);
+						m_outbuf->sputc(' ');
+						writeIri(RDF::rest.uri());
+						m_outbuf->sputc(' ');
+						writeSkolem(next);
+						endLine();
+						
+						cell.swap(next);
+					} else {
+						writeLine(cell, RDF::rest, RDF::nil);
+					}
+				}
+			} else {
+				const GraphTemplate &graph = static_cast<const GraphTemplate &>(*node);
+				
+				enterGraph(&graph);
+				
+				for (const TriplePattern &t : graph)
+					writeLine(t.subject(), t.property(), t.object());
+			}
+		}
+		
+		m_pending.clear();
+	}
+
+}
@@ -0,0 +1,153 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_NTRIPLES_WRITER_HH
+#define CARL_NTRIPLES_WRITER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Parser.hh"
+#include "BlankNodeIdGenerator.hh"
+#include "Hash.hh"
+#include "NumberFormat.hh"
+
+namespace n3 {
+	
+	///
+	/// Writes N-Triples, or N-Quads when quads is set, in canonical form.
+	///
+	/// Blank nodes, lists, graphs and variables are skolemized with N3PFormatter::SKOLEM_PREFIX,
+	/// blank nodes are named the same way as in N3P output.
+	/// Lists are written as rdf:first/rdf:rest chains.
+	/// In N-Quads the triples of a graph are written in a named graph with the skolem IRI of the graph,
+	/// N-Triples can not represent them so they are left out.
+	/// For a deterministic document (see Parser::deterministic) the skolem ids are deterministic too.
+	///
+	class NTriplesWriter : public DefaultTripleSink, private N3NodeVisitor {
+		
+		/// A list or graph referred to from the current line, written after it.
+		struct Pending {
+			const N3Node *node;
+			std::string iri;
+			const GraphTemplate *graph; // the graph containing node
+		};
+		
+		static const char LITERAL_ESCAPE[];
+		static const char IRI_ESCAPE[];
+		
+		std::streambuf *m_outbuf;
+		bool m_quads;
+		bool m_normalizeNumbers;
+		
+		BlankNodeIdGenerator m_ids;
+		std::vector<Pending> m_pending;
+		const GraphTemplate *m_graph; // the graph of the current line, null at the top level
+		std::string m_graphId;        // the skolem id of m_graph
+		
+		void write(const std::string &s, const char *escape);
+		void writeUchar(char c);
+		
+		void writeIri(const std::string &iri)
+		{
+			m_outbuf->sputc('<');
+			write(iri, IRI_ESCAPE);
+			m_outbuf->sputc('>');
+		}
+		
+		void writeSkolem(const std::string &id);
+		
+		/// Makes graph the graph of the following lines, naming it once instead of on every line.
+		void enterGraph(const GraphTemplate *graph)
+		{
+			if (graph && graph != m_graph)
+				m_graphId = m_ids.generate("g" + graph->id());
+			
+			m_graph = graph;
+		}
+		
+		void writeLiteral(const std::string &lexical, const std::string &datatype)
+		{
+			m_outbuf->sputc('"');
+			write(lexical, LITERAL_ESCAPE);
+			m_outbuf->sputn("\"^^", 3);
+			writeIri(datatype);
+		}
+		
+		void writeNumber(const std::string &lexical, const std::string &datatype, bool (*canonical)(std::streambuf *, const std::string &))
+		{
+			m_outbuf->sputc('"');
+			if (!m_normalizeNumbers || !canonical(m_outbuf, lexical))
+				write(lexical, LITERAL_ESCAPE);
+			m_outbuf->sputn("\"^^", 3);
+			writeIri(datatype);
+		}
+		
+		void writeLine(const N3Node &subject, const N3Node &property, const N3Node &object);
+		void writeLine(const std::string &subject, const URIResource &property, const N3Node &object);
+		void endLine();
+		
+		void visit(const URIResource &resource) override;
+		void visit(const BlankNode &blankNode) override;
+		void visit(const Literal &literal) override;
+		void visit(const BooleanLiteral &literal) override;
+		void visit(const IntegerLiteral &literal) override;
+		void visit(const DoubleLiteral &literal) override;
+		void visit(const DecimalLiteral &literal) override;
+		void visit(const StringLiteral &literal) override;
+		void visit(const RDFList &list) override;
+		void visit(const GraphTemplate &graph) override;
+		void visit(const Var &var) override;
+		
+	public:
+		NTriplesWriter(std::ostream &out, bool quads) : DefaultTripleSink(), N3NodeVisitor(), m_outbuf(out.rdbuf()), m_quads(quads), m_normalizeNumbers(false), m_ids(), m_pending(), m_graph(nullptr), m_graphId() {}
+		
+		/// Writes numbers in their canonical form instead of keeping their lexical form.
+		void normalizeNumbers(bool normalize)
+		{
+			m_normalizeNumbers = normalize;
+		}
+		
+		void end() override
+		{
+			m_outbuf->pubsync();
+		}
+		
+		void document(const std::string &source) override
+		{
+			m_ids.initialize();
+		}
+		
+		/// Derives the skolem ids from seed too, with a prefix apart from the one of the blank nodes.
+		void deterministic(std::uint64_t seed) override
+		{
+			Hash64 hash;
+			hash.update(Hash64::toHex(seed));
+			hash.update("skolem");
+			
+			m_ids.initialize(hash.value());
+		}
+		
+		void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override;
+	};
+
+}
+
+#endif /* CARL_NTRIPLES_WRITER_HH */
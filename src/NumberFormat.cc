@@ -0,0 +1,310 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "NumberFormat.hh"
+
+#include <cstdlib>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		const char ZEROS[] = "0000000000000000";
+		
+		bool isDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+		
+		/// The parts of a numeric lexical form: [sign] int [. frac] [e|E exponent].
+		struct Number {
+			bool negative;
+			const char *intBegin, *intEnd;
+			const char *fracBegin, *fracEnd;
+			const char *expBegin, *expEnd; // including its sign
+			
+			/// Returns false when s is not of the form [+-]digits[.digits][(e|E)[+-]digits], with at least one digit in the mantissa.
+			bool parse(const std::string &s, bool point, bool exponent)
+			{
+				const char *p   = s.data();
+				const char *end = p + s.length();
+				
+				negative = p < end && *p == '-';
+				if (p < end && (*p == '-' || *p == '+'))
+					++p;
+				
+				intBegin = p;
+				while (p < end && isDigit(*p))
+					++p;
+				intEnd = p;
+				
+				fracBegin = fracEnd = p;
+				if (point && p < end && *p == '.') {
+					fracBegin = ++p;
+					while (p < end && isDigit(*p))
+						++p;
+					fracEnd = p;
+				}
+				
+				if (intBegin == intEnd && fracBegin == fracEnd)
+					return false;
+				
+				expBegin = expEnd = p;
+				if (exponent && p < end && (*p == 'e' || *p == 'E')) {
+					expBegin = ++p;
+					if (p < end && (*p == '-' || *p == '+'))
+						++p;
+					const char *digits = p;
+					while (p < end && isDigit(*p))
+						++p;
+					if (p == digits)
+						return false;
+					expEnd = p;
+				}
+				
+				return p == end;
+			}
+		};
+		
+		void writeLong(std::streambuf *out, long n)
+		{
+			char buf[24];
+			char *p = buf + sizeof(buf);
+			
+			bool negative = n < 0;
+			unsigned long u = negative ? 0UL - static_cast<unsigned long>(n) : static_cast<unsigned long>(n);
+			
+			do {
+				*--p = static_cast<char>('0' + u % 10);
+				u /= 10;
+			} while (u);
+			
+			if (negative)
+				*--p = '-';
+			
+			out->sputn(p, buf + sizeof(buf) - p);
+		}
+	}
+	
+	void NumberFormat::writeZeros(std::streambuf *out, std::size_t count)
+	{
+		const std::size_t size = sizeof(ZEROS) - 1;
+		
+		while (count > size) {
+			out->sputn(ZEROS, size);
+			count -= size;
+		}
+		out->sputn(ZEROS, count);
+	}
+	
+	void NumberFormat::writeFixed(std::streambuf *out, const std::string &lexical)
+	{
+		// values like .5 and -.5 are not allowed in prolog
+		// values like 5., 5.E0 are not allowed in prolog
+		const char *s = lexical.c_str();
+		std::size_t length = lexical.length();
+		
+		std::size_t p = lexical.find('.');
+		if (p == std::string::npos) {
+			out->sputn(s, length);
+			return;
+		}
+		
+		if (p == 0 || (p == 1 && s[0] == '-')) {
+			out->sputn(s, p);
+			out->sputc('0');
+		} else {
+			out->sputn(s, p);
+		}
+		
+		out->sputc('.');
+		++p;
+		
+		if (p == length || s[p] == 'E' || s[p] == 'e')
+			out->sputc('0');
+		
+		out->sputn(s + p, length - p);
+	}
+	
+	bool NumberFormat::writeCanonicalInteger(std::streambuf *out, const std::string &lexical)
+	{
+		Number n;
+		if (!n.parse(lexical, false, false))
+			return false;
+		
+		const char *p = n.intBegin;
+		while (p < n.intEnd - 1 && *p == '0')
+			++p;
+		
+		if (n.negative && !(p + 1 == n.intEnd && *p == '0'))
+			out->sputc('-');
+		
+		out->sputn(p, n.intEnd - p);
+		
+		return true;
+	}
+	
+	bool NumberFormat::writeCanonicalDecimal(std::streambuf *out, const std::string &lexical)
+	{
+		Number n;
+		if (!n.parse(lexical, true, false))
+			return false;
+		
+		const char *intBegin = n.intBegin;
+		while (intBegin < n.intEnd && *intBegin == '0')
+			++intBegin;
+		
+		const char *fracEnd = n.fracEnd;
+		while (fracEnd > n.fracBegin && fracEnd[-1] == '0')
+			--fracEnd;
+		
+		if (n.negative && (intBegin < n.intEnd || n.fracBegin < fracEnd))
+			out->sputc('-');
+		
+		if (intBegin < n.intEnd)
+			out->sputn(intBegin, n.intEnd - intBegin);
+		else
+			out->sputc('0');
+		
+		out->sputc('.');
+		
+		if (n.fracBegin < fracEnd)
+			out->sputn(n.fracBegin, fracEnd - n.fracBegin);
+		else
+			out->sputc('0');
+		
+		return true;
+	}
+	
+	bool NumberFormat::writeCanonicalDouble(std::streambuf *out, const std::string &lexical)
+	{
+		Number n;
+		if (!n.parse(lexical, true, true))
+			return false;
+		
+		// the mantissa digits, without the point
+		std::size_t intLength  = n.intEnd - n.intBegin;
+		std::size_t fracLength = n.fracEnd - n.fracBegin;
+		std::size_t length     = intLength + fracLength;
+		
+		auto digit = [&](std::size_t i) { return i < intLength ? n.intBegin[i] : n.fracBegin[i - intLength]; };
+		
+		std::size_t first = 0;
+		while (first < length && digit(first) == '0')
+			++first;
+		
+		if (first == length) {
+			// doubles have a negative zero
+			if (n.negative)
+				out->sputc('-');
+			out->sputn("0.0E0", 5);
+			return true;
+		}
+		
+		std::size_t last = length;
+		while (digit(last - 1) == '0')
+			--last;
+		
+		// exponents beyond the range of long are saturated, no double has them anyway
+		long exponent = 0;
+		if (n.expBegin < n.expEnd)
+			exponent = std::strtol(n.expBegin, nullptr, 10);
+		
+		const long LIMIT = 1000000000L;
+		if (exponent > LIMIT)
+			exponent = LIMIT;
+		else if (exponent < -LIMIT)
+			exponent = -LIMIT;
+		
+		exponent += static_cast<long>(intLength) - static_cast<long>(first) - 1;
+		
+		if (n.negative)
+			out->sputc('-');
+		
+		out->sputc(digit(first));
+		out->sputc('.');
+		
+		if (first + 1 < last) {
+			for (std::size_t i = first + 1; i < last; ) {
+				// copy runs of digits within the integer or the fraction part
+				const char *run  = i < intLength ? n.intBegin + i : n.fracBegin + (i - intLength);
+				std::size_t stop = i < intLength && last > intLength ? intLength : last;
+				
+				out->sputn(run, stop - i);
+				i = stop;
+			}
+		} else {
+			out->sputc('0');
+		}
+		
+		out->sputc('E');
+		writeLong(out, exponent);
+		
+		return true;
+	}
+	
+	void NumberFormat::writeRational(std::streambuf *out, const std::string &lexical) const
+	{
+		if (m_normalize) {
+			Number n;
+			if (n.parse(lexical, true, false)) {
+				// numerator: the digits without leading zeros, denominator: 10^(digits after the point)
+				const char *fracEnd = n.fracEnd;
+				while (fracEnd > n.fracBegin && fracEnd[-1] == '0')
+					--fracEnd;
+				
+				const char *intBegin = n.intBegin;
+				while (intBegin < n.intEnd && *intBegin == '0')
+					++intBegin;
+				
+				const char *fracBegin = n.fracBegin;
+				if (intBegin == n.intEnd) {
+					while (fracBegin < fracEnd && *fracBegin == '0')
+						++fracBegin;
+				}
+				
+				if (intBegin == n.intEnd && fracBegin == fracEnd) {
+					out->sputn("0 rdiv 1", 8);
+					return;
+				}
+				
+				if (n.negative)
+					out->sputc('-');
+				out->sputn(intBegin, n.intEnd - intBegin);
+				out->sputn(fracBegin, fracEnd - fracBegin);
+				out->sputn(" rdiv 1", 7);
+				writeZeros(out, fracEnd - n.fracBegin);
+				
+				return;
+			}
+		}
+		
+		std::size_t p = lexical.find('.');
+		if (p == std::string::npos) {
+			out->sputn(lexical.c_str(), lexical.length());
+			out->sputn(" rdiv 1", 7);
+		} else {
+			out->sputn(lexical.c_str(), p++);
+			std::size_t len = lexical.length() - p;
+			out->sputn(lexical.c_str() + p, len);
+			out->sputn(" rdiv 1", 7);
+			writeZeros(out, len);
+		}
+	}
+
+}
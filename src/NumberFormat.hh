@@ -0,0 +1,81 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_NUMBER_FORMAT_HH
+#define CARL_NUMBER_FORMAT_HH
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace n3 {
+	
+	///
+	/// Writes the lexical forms of integer, decimal and double literals as Prolog numbers,
+	/// without allocating.
+	///
+	/// By default the lexical form is kept, only a missing digit before or after the decimal
+	/// point is added. A leading '+' is kept as well, so +3 reaches a Prolog reader as the
+	/// term +(3) rather than as a number token. When normalizing, the canonical XSD form is
+	/// written: no '+' sign, no superfluous zeros and doubles in scientific notation (1.5E3),
+	/// which are all Prolog numbers. Lexical forms that are not valid are always written unchanged.
+	///
+	class NumberFormat {
+		
+		bool m_normalize;
+		
+		static void writeZeros(std::streambuf *out, std::size_t count);
+		
+		/// Writes the lexical form, adding a zero where a digit before or after the point is missing.
+		static void writeFixed(std::streambuf *out, const std::string &lexical);
+		
+	public:
+		explicit NumberFormat(bool normalize = false) : m_normalize(normalize) {}
+		
+		bool normalize() const { return m_normalize; }
+		void normalize(bool normalize) { m_normalize = normalize; }
+		
+		void writeInteger(std::streambuf *out, const std::string &lexical) const
+		{
+			if (!m_normalize || !writeCanonicalInteger(out, lexical))
+				out->sputn(lexical.c_str(), lexical.length());
+		}
+		
+		void writeDecimal(std::streambuf *out, const std::string &lexical) const
+		{
+			if (!m_normalize || !writeCanonicalDecimal(out, lexical))
+				writeFixed(out, lexical);
+		}
+		
+		void writeDouble(std::streambuf *out, const std::string &lexical) const
+		{
+			if (!m_normalize || !writeCanonicalDouble(out, lexical))
+				writeFixed(out, lexical);
+		}
+		
+		/// Write the canonical XSD form, nothing is written and false is returned for an invalid lexical form.
+		static bool writeCanonicalInteger(std::streambuf *out, const std::string &lexical);
+		static bool writeCanonicalDecimal(std::streambuf *out, const std::string &lexical);
+		static bool writeCanonicalDouble(std::streambuf *out, const std::string &lexical);
+		
+		/// Writes a decimal as a rational number: "1.25" becomes "125 rdiv 100".
+		void writeRational(std::streambuf *out, const std::string &lexical) const;
+	};
+
+}
+
+#endif /* CARL_NUMBER_FORMAT_HH */
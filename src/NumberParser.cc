@@ -0,0 +1,236 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "NumberParser.hh"
+
+#include <cstdlib>
+#include <limits>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		const double POW10[] = {
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		
+		const int MAX_POW10 = 22;
+		const int MAX_FAST_DIGITS = 19;
+		const std::uint64_t MAX_FAST_SIGNIFICAND = std::uint64_t(1) << 53;
+		
+		bool isDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+		
+		bool parseSign(const char *&p, const char *end)
+		{
+			if (p != end && (*p == '+' || *p == '-'))
+				return *p++ == '-';
+			
+			return false;
+		}
+		
+		/// Appends a digit to n, sets big when the result would exceed limit.
+		void accumulate(std::uint64_t &n, char c, std::uint64_t limit, bool &big)
+		{
+			unsigned digit = c - '0';
+			
+			if (big || n > (limit - digit) / 10)
+				big = true;
+			else
+				n = n * 10 + digit;
+		}
+		
+		std::uint64_t limit(bool negative)
+		{
+			return negative ? std::uint64_t(1) << 63 : std::numeric_limits<std::int64_t>::max();
+		}
+		
+		std::int64_t toSigned(std::uint64_t n, bool negative)
+		{
+			if (!negative)
+				return static_cast<std::int64_t>(n);
+			
+			return n == std::uint64_t(1) << 63 ? std::numeric_limits<std::int64_t>::min() : -static_cast<std::int64_t>(n);
+		}
+	}
+	
+	bool NumberParser::parseInteger(const std::string &lexical, std::int64_t &value, bool &big)
+	{
+		const char *p = lexical.c_str(), *end = p + lexical.length();
+		bool negative = parseSign(p, end);
+		
+		if (p == end)
+			return false;
+		
+		std::uint64_t n = 0, max = limit(negative);
+		big = false;
+		for (; p != end; ++p) {
+			if (!isDigit(*p))
+				return false;
+			accumulate(n, *p, max, big);
+		}
+		
+		value = big ? 0 : toSigned(n, negative);
+		
+		return true;
+	}
+	
+	bool NumberParser::parseDecimal(const std::string &lexical, std::int64_t &unscaled, unsigned &scale, bool &big)
+	{
+		const char *p = lexical.c_str(), *end = p + lexical.length();
+		bool negative = parseSign(p, end);
+		
+		const char *intBegin = p;
+		while (p != end && isDigit(*p))
+			++p;
+		const char *intEnd = p;
+		
+		const char *fracBegin = end, *fracEnd = end;
+		if (p != end && *p == '.') {
+			fracBegin = ++p;
+			while (p != end && isDigit(*p))
+				++p;
+			fracEnd = p;
+		}
+		
+		if (p != end || (intBegin == intEnd && fracBegin == fracEnd))
+			return false;
+		
+		while (fracEnd != fracBegin && fracEnd[-1] == '0')
+			--fracEnd;
+		
+		std::uint64_t n = 0, max = limit(negative);
+		big = false;
+		for (p = intBegin; p != intEnd; ++p)
+			accumulate(n, *p, max, big);
+		for (p = fracBegin; p != fracEnd; ++p)
+			accumulate(n, *p, max, big);
+		
+		unscaled = big ? 0 : toSigned(n, negative);
+		scale    = static_cast<unsigned>(fracEnd - fracBegin);
+		
+		return true;
+	}
+	
+	bool NumberParser::parseDouble(const std::string &lexical, double &value)
+	{
+		if (lexical == "INF" || lexical == "+INF") {
+			value = std::numeric_limits<double>::infinity();
+			return true;
+		}
+		if (lexical == "-INF") {
+			value = -std::numeric_limits<double>::infinity();
+			return true;
+		}
+		if (lexical == "NaN") {
+			value = std::numeric_limits<double>::quiet_NaN();
+			return true;
+		}
+		
+		const char *p = lexical.c_str(), *end = p + lexical.length();
+		bool negative = parseSign(p, end);
+		
+		std::uint64_t significand = 0;
+		int digits = 0;     // significant digits in the significand
+		int exponent = 0;   // decimal exponent of the last digit in the significand
+		bool any = false;   // seen a digit
+		bool exact = true;  // all significant digits fit the significand
+		
+		for (; p != end && isDigit(*p); ++p) {
+			any = true;
+			if (digits == 0 && *p == '0')
+				continue;
+			if (digits < MAX_FAST_DIGITS) {
+				significand = significand * 10 + (*p - '0');
+				++digits;
+			} else {
+				exact = false;
+			}
+		}
+		
+		if (p != end && *p == '.') {
+			for (++p; p != end && isDigit(*p); ++p) {
+				any = true;
+				if (digits == 0 && *p == '0') {
+					--exponent;
+					continue;
+				}
+				if (digits < MAX_FAST_DIGITS) {
+					significand = significand * 10 + (*p - '0');
+					++digits;
+					--exponent;
+				} else {
+					exact = false;
+				}
+			}
+		}
+		
+		if (!any)
+			return false;
+		
+		if (p != end && (*p == 'e' || *p == 'E')) {
+			++p;
+			bool negativeExponent = parseSign(p, end);
+			if (p == end)
+				return false;
+			
+			int e = 0;
+			for (; p != end; ++p) {
+				if (!isDigit(*p))
+					return false;
+				if (e < 100000)
+					e = e * 10 + (*p - '0');
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+		
+		if (p != end)
+			return false;
+		
+		if (significand == 0) {
+			value = negative ? -0.0 : 0.0;
+		} else if (exact && significand <= MAX_FAST_SIGNIFICAND && exponent >= -MAX_POW10 && exponent <= MAX_POW10) {
+			value = static_cast<double>(significand);
+			value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+			if (negative)
+				value = -value;
+		} else {
+			value = std::strtod(lexical.c_str(), nullptr);
+		}
+		
+		return true;
+	}
+	
+	bool NumberParser::parseBoolean(const std::string &lexical, bool &value)
+	{
+		if (lexical == "true" || lexical == "1") {
+			value = true;
+			return true;
+		}
+		if (lexical == "false" || lexical == "0") {
+			value = false;
+			return true;
+		}
+		
+		return false;
+	}
+
+}
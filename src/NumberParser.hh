@@ -0,0 +1,50 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_NUMBER_PARSER_HH
+#define CARL_NUMBER_PARSER_HH
+
+#include <cstdint>
+#include <string>
+
+namespace n3 {
+	
+	///
+	/// Parses the lexical forms of xsd:integer, xsd:decimal, xsd:double and xsd:boolean
+	/// into native values.
+	///
+	/// All functions return false for an invalid lexical form. Values that do not fit
+	/// a native type are valid but set big: the lexical form stays authoritative.
+	///
+	class NumberParser {
+	public:
+		
+		static bool parseInteger(const std::string &lexical, std::int64_t &value, bool &big);
+		
+		/// The value is unscaled / 10^scale, trailing zeros of the fraction are dropped.
+		static bool parseDecimal(const std::string &lexical, std::int64_t &unscaled, unsigned &scale, bool &big);
+		
+		/// Exact when the significand has at most 19 digits and fits 53 bits and the exponent
+		/// is at most 22 (Clinger's fast path), otherwise strtod is used.
+		static bool parseDouble(const std::string &lexical, double &value);
+		
+		static bool parseBoolean(const std::string &lexical, bool &value);
+	};
+
+}
+
+#endif /* CARL_NUMBER_PARSER_HH */
@@ -0,0 +1,169 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "ParallelN3PWriter.hh"
+
+#include <exception>
+
+
+namespace n3 {
+	
+	ParallelN3PWriter::ParallelN3PWriter(std::ostream &out, unsigned threads)
+		: DefaultTripleSink(), m_writer(out), m_normalizeNumbers(false), m_maxPending(2 * threads), m_source(), m_batch(), m_pending(), m_mutex(), m_idle(), m_pool(threads)
+	{
+		// nop
+	}
+	
+	ParallelN3PWriter::~ParallelN3PWriter()
+	{
+		try {
+			writePending();
+		} catch (...) {
+			// the statements after a failed batch are lost
+		}
+	}
+	
+	void ParallelN3PWriter::add(Event &&event)
+	{
+		if (!m_batch) {
+			m_batch = std::make_shared<Batch>();
+			m_batch->events.reserve(BATCH_SIZE);
+			m_batch->source = m_source;
+		}
+		
+		m_batch->events.push_back(std::move(event));
+	}
+	
+	void ParallelN3PWriter::submit()
+	{
+		if (!m_batch)
+			return;
+		
+		while (m_pending.size() >= m_maxPending)
+			writeFirst();
+		
+		std::shared_ptr<Batch> batch = std::move(m_batch);
+		m_pending.emplace_back(batch, batch->done.get_future());
+		
+		m_pool.execute([this, batch] {
+			try {
+				format(*batch);
+				batch->done.set_value();
+			} catch (...) {
+				batch->done.set_exception(std::current_exception());
+			}
+		});
+	}
+	
+	void ParallelN3PWriter::writeFirst()
+	{
+		std::shared_ptr<Batch> batch = std::move(m_pending.front().first);
+		std::future<void> done = std::move(m_pending.front().second);
+		m_pending.pop_front();
+		
+		done.get(); // rethrows an exception of the formatter
+		
+		m_writer.append(batch->text.data(), batch->text.size());
+		m_writer.addCount(batch->count);
+	}
+	
+	void ParallelN3PWriter::writePending()
+	{
+		submit();
+		
+		while (!m_pending.empty())
+			writeFirst();
+	}
+	
+	void ParallelN3PWriter::format(Batch &batch)
+	{
+		std::unique_ptr<Formatter> formatter;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_idle.empty()) {
+				formatter = std::move(m_idle.back());
+				m_idle.pop_back();
+			}
+		}
+		
+		if (!formatter)
+			formatter.reset(new Formatter(m_normalizeNumbers));
+		
+		formatter->writer.reset();
+		formatter->writer.source(batch.source);
+		
+		for (const Event &event : batch.events)
+			event.replay(formatter->writer);
+		
+		batch.events.clear();
+		batch.text = formatter->out.str();
+		batch.count = formatter->writer.count();
+		formatter->out.str(std::string());
+		
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_idle.push_back(std::move(formatter));
+	}
+	
+	void ParallelN3PWriter::start()
+	{
+		m_writer.start();
+	}
+	
+	void ParallelN3PWriter::end()
+	{
+		writePending();
+		m_writer.end();
+	}
+	
+	void ParallelN3PWriter::document(const std::string &source)
+	{
+		add(Event(Event::DOCUMENT, source));
+		m_source = source;
+	}
+	
+	void ParallelN3PWriter::prefix(const std::string &prefix, const std::string &ns)
+	{
+		add(Event(Event::PREFIX, prefix, ns));
+	}
+	
+	void ParallelN3PWriter::triple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		add(Event(Event::TRIPLE, subject, property, &object));
+		
+		if (m_batch->events.size() >= BATCH_SIZE)
+			submit();
+	}
+	
+	void ParallelN3PWriter::beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula)
+	{
+		writePending();
+		
+		m_writer.source(m_source);
+		m_writer.beginFormula(subject, property, formula);
+	}
+	
+	void ParallelN3PWriter::formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object)
+	{
+		m_writer.formulaTriple(subject, property, object);
+	}
+	
+	void ParallelN3PWriter::endFormula()
+	{
+		m_writer.endFormula();
+	}
+
+}
@@ -0,0 +1,123 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_PARALLEL_N3P_WRITER_HH
+#define CARL_PARALLEL_N3P_WRITER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CN3Writer.hh"
+#include "Event.hh"
+#include "ThreadPool.hh"
+
+namespace n3 {
+	
+	///
+	/// N3P writer formatting the statements on a pool of threads. The statements
+	/// are copied into batches, every batch is formatted into its own buffer by
+	/// a CN3Writer of the pool and the buffers are written in the original order,
+	/// so the output is the same as the output of a CN3Writer.
+	///
+	/// A streamed formula is written on the calling thread, after the batches
+	/// before it: it is streamed because it is too large to hold in a batch.
+	///
+	class ParallelN3PWriter : public DefaultTripleSink {
+		
+		struct Batch {
+			std::vector<Event> events;
+			std::string source; // the document the first event belongs to
+			std::string text;
+			std::uint64_t count;
+			std::promise<void> done;
+		};
+		
+		/// A writer of the pool with the buffer it formats into.
+		struct Formatter {
+			std::ostringstream out;
+			CN3Writer writer;
+			
+			explicit Formatter(bool normalizeNumbers) : out(), writer(out)
+			{
+				writer.normalizeNumbers(normalizeNumbers);
+			}
+		};
+		
+		CN3Writer m_writer; // writes the prologue, the epilogue and the formatted batches
+		bool m_normalizeNumbers;
+		std::size_t m_maxPending;
+		std::string m_source;
+		std::shared_ptr<Batch> m_batch;
+		std::deque<std::pair<std::shared_ptr<Batch>, std::future<void>>> m_pending;
+		
+		std::mutex m_mutex;
+		std::vector<std::unique_ptr<Formatter>> m_idle;
+		
+		ThreadPool m_pool; // last, its destructor waits for the tasks using the members above
+		
+		void add(Event &&event);
+		
+		void submit();
+		void writeFirst();
+		void writePending();
+		
+		void format(Batch &batch);
+		
+	public:
+		
+		static const std::size_t BATCH_SIZE = 2048; // events
+		
+		ParallelN3PWriter(std::ostream &out, unsigned threads);
+		
+		/// Writes the statements received so far when end() was not called, like after a parse error.
+		~ParallelN3PWriter();
+		
+		ParallelN3PWriter(const ParallelN3PWriter &) = delete;
+		ParallelN3PWriter &operator=(const ParallelN3PWriter &) = delete;
+		
+		/// Writes numbers in their canonical form instead of keeping their lexical form.
+		void normalizeNumbers(bool normalize)
+		{
+			m_normalizeNumbers = normalize;
+			m_writer.normalizeNumbers(normalize);
+		}
+		
+		void start() override;
+		void end() override;
+		void document(const std::string &source) override;
+		void prefix(const std::string &prefix, const std::string &ns) override;
+		void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override;
+		
+		bool streamsFormulas() const override { return true; }
+		void beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula) override;
+		void formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object) override;
+		void endFormula() override;
+		
+		std::uint64_t count() const override { return m_writer.count(); }
+	};
+
+}
+
+#endif /* CARL_PARALLEL_N3P_WRITER_HH */
@@ -14,19 +14,53 @@
 // limitations under the License.
 //
 
+#include <cstring>
 #include <utility>
 
 #include "Parser.hh"
 #include "Utf8.hh"
 #include "Utf16.hh"
 #include "Model.hh"
+#include "NumberParser.hh"
 
 namespace n3 {
 
-	const std::string Parser::LOCAL_NAME_ESCAPE_CHARS("_~.-!$&\'()*+,;=/?#@%");
+	// The characters that can be escaped in a local name: _~.-!$&'()*+,;=/?#@%
+	alignas(256) const bool Parser::LOCAL_NAME_ESCAPE[] = {
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0x00 - 0x1F
+		0,1,0,1,1,1,1,1,1,1,1,1,1,1,1,1,  0,0,0,0,0,0,0,0,0,0,0,1,0,1,0,1, // 0x20 - 0x3F
+		1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1, // 0x40 - 0x5F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0, // 0x60 - 0x7F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0x80 - 0x9F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0xA0 - 0xBF
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0xC0 - 0xDF
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0  // 0xE0 - 0xFF
+	};
 	
-	// We do not check if uris are valid, this is used when translating \uxxxx escapes to chars
-	const std::string Parser::INVALID_ESCAPES("<>\"{}|^`\\");
+	// We do not check if uris are valid, this is used when translating \uxxxx escapes to chars.
+	// Invalid are the control characters, space and <>"{}|^`\ as well.
+	alignas(256) const bool Parser::INVALID_ESCAPE[] = {
+		1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x00 - 0x1F
+		1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,1,0,1,0, // 0x20 - 0x3F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,1,0,1,0, // 0x40 - 0x5F
+		1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,1,1,1,0,0, // 0x60 - 0x7F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0x80 - 0x9F
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0xA0 - 0xBF
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 0xC0 - 0xDF
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0  // 0xE0 - 0xFF
+	};
+	
+	// The value of every hexadecimal digit, the lexer only produces escapes with valid digits
+	alignas(256) const std::uint8_t Parser::HEX_VALUE[] = {
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x00 - 0x1F
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0, 0, 0, 0, // 0x20 - 0x3F
+		 0,10,11,12,13,14,15, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x40 - 0x5F
+		 0,10,11,12,13,14,15, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x60 - 0x7F
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x80 - 0x9F
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xA0 - 0xBF
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0xC0 - 0xDF
+		 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0  // 0xE0 - 0xFF
+	};
 
 	inline Uri Parser::resolve(const std::string &uri)
 	{
@@ -58,9 +92,14 @@ namespace n3 {
 		if (i == m_prefixMap.end())
 			throw ParseException("unknown prefix: " + prefix, line());
 		
-		return i->second + unescape(p + 1, pname);
+		std::string uri;
+		uri.reserve(i->second.length() + pname.length() - p - 1);
+		uri.append(i->second);
+		unescape(pname, p + 1, uri);
+		
+		return uri;
 		// checking for valid uris is redundant here, i->second is a valid uri, concatenating a fragment or path cannot give a invalid uri.
-		//return static_cast<std::string>(Uri(i->second + unescape(p + 1, pname)));
+		//return static_cast<std::string>(Uri(uri));
 	}
 	
 	
@@ -189,8 +228,7 @@ namespace n3 {
 	void Parser::base()
 	{
 		match(Token::Base);
-		match(Token::IriRef);
-		std::string u = extractUri(m_lexeme);
+		std::string u = matchUri();
 		match('.');
 		
 		m_base = resolve(std::move(u));
@@ -201,8 +239,7 @@ namespace n3 {
 		match(Token::Prefix);
 		match(Token::PNameNS);
 		std::string prefix = m_lexeme.substr(0, m_lexeme.length() - 1);
-		match(Token::IriRef);
-		std::string u = extractUri(m_lexeme);
+		std::string u = matchUri();
 		match('.');
 		
 		std::string ns = static_cast<std::string>(resolve(std::move(u)));
@@ -213,9 +250,7 @@ namespace n3 {
 	void Parser::sparqlBase()
 	{
 		match(Token::SparqlBase);
-		match(Token::IriRef);
-		
-		std::string u = extractUri(m_lexeme);
+		std::string u = matchUri();
 		
 		m_base = resolve(std::move(u));
 	}
@@ -225,8 +260,7 @@ namespace n3 {
 		match(Token::SparqlPrefix);
 		match(Token::PNameNS);
 		std::string prefix = m_lexeme.substr(0, m_lexeme.length() - 1);
-		match(Token::IriRef);
-		std::string u = extractUri(m_lexeme);
+		std::string u = matchUri();
 		
 		std::string ns = static_cast<std::string>(resolve(std::move(u)));
 		m_sink->prefix(prefix, ns);
@@ -294,45 +328,27 @@ namespace n3 {
 			
 			match();
 			
+			std::unique_ptr<N3Node> property;
 			if (m_lookAhead == Token::PNameLN || m_lookAhead == Token::IriRef || m_lookAhead == Token::PNameNS) {
-				const URIResource property(iri());
-				
-				std::unique_ptr<BlankNode> b(new BlankNode(m_blanks.generate()));
-				
-				if (forward) {
-					graph->triple(*s, property, *b);
-				} else {
-					graph->triple(*b, property, *s);
-				}
-				
-				s = std::move(b);
+				property.reset(new URIResource(iri()));
 			} else if (m_lookAhead == Token::BlankNodeLabel) {
 				match();
-				const BlankNode property(m_blanks.generate(m_lexeme.substr(2)));
-				
-				std::unique_ptr<BlankNode> b(new BlankNode(m_blanks.generate()));
-				
-				if (forward) {
-					graph->triple(*s, property, *b);
-				} else {
-					graph->triple(*b, property, *s);
-				}
-				
-				s = std::move(b);
+				property.reset(new BlankNode(m_blanks.generate(m_lexeme.substr(2))));
 			} else if (m_lookAhead == '[') {
-				const std::unique_ptr<BlankNode> property = blanknodepropertylist();
-				
-				std::unique_ptr<BlankNode> b(new BlankNode(m_blanks.generate()));
-			
-				if (forward) {
-					graph->triple(*s, *property, *b);
-				} else {
-					graph->triple(*b, *property, *s);
-				}
-				
-				s = std::move(b);
+				property = blanknodepropertylist();
 			} else
 				throw ParseException("expected IRI ref or prefixed name as path", line());
+			
+			std::unique_ptr<N3Node> b(new BlankNode(m_blanks.generate()));
+			std::unique_ptr<N3Node> next(b->clone());
+			
+			if (forward) {
+				graph->triple(std::move(s), std::move(property), std::move(b));
+			} else {
+				graph->triple(std::move(b), std::move(property), std::move(s));
+			}
+			
+			s = std::move(next);
 		}
 		
 		return s;
@@ -370,32 +386,28 @@ namespace n3 {
 		} else if (m_lookAhead == '(') {
 			return collection(graph);
 		} else if (m_lookAhead == Token::StringLiteralQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::StringLiteralLongQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::Integer) {
 			match();
-			return std::unique_ptr<Literal>(new IntegerLiteral(m_lexeme));
+			return integer(m_lexeme);
 		} else if (m_lookAhead == Token::Decimal) {
 			match();
-			return std::unique_ptr<Literal>(new DecimalLiteral(m_lexeme));
+			return decimal(m_lexeme);
 		} else if (m_lookAhead == Token::Double) {
 			match();
-			return std::unique_ptr<Literal>(new DoubleLiteral(m_lexeme));
+			return doubleLiteral(m_lexeme);
 		} else if (m_lookAhead == Token::True) {
 			match();
-			return std::unique_ptr<Literal>(new BooleanLiteral(m_lexeme));
+			return boolean(m_lexeme);
 		} else if (m_lookAhead == Token::False) {
 			match();
-			return std::unique_ptr<Literal>(new BooleanLiteral(m_lexeme));
+			return boolean(m_lexeme);
 		} else if (m_lookAhead == Token::StringLiteralSingleQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::StringLiteralLongSingleQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else
 			throw ParseException("expected blank node, uri or list as subject", line());
 	}
@@ -445,8 +457,7 @@ namespace n3 {
 	std::string Parser::iri()
 	{
 		if (m_lookAhead == Token::IriRef) {
-			match();
-			std::string uri = extractUri(m_lexeme);
+			std::string uri = matchUri();
 			if (Uri::absolute(uri))
 				return std::move(uri);
 			return static_cast<std::string>(resolve(std::move(uri)));
@@ -465,21 +476,13 @@ namespace n3 {
 		if (m_lookAhead == Token::PNameLN || m_lookAhead == Token::IriRef || m_lookAhead == Token::BlankNodeLabel || m_lookAhead == Token::PNameNS || m_lookAhead == '{' || m_lookAhead == '[' || m_lookAhead == '(' ||
 		    m_lookAhead == Token::StringLiteralQuote || m_lookAhead == Token::StringLiteralSingleQuote || m_lookAhead == Token::StringLiteralLongSingleQuote || m_lookAhead == Token::StringLiteralLongQuote ||
 		    m_lookAhead == Token::True || m_lookAhead == Token::False || m_lookAhead == Token::Integer || m_lookAhead == Token::Decimal || m_lookAhead == Token::Double) {
-			std::unique_ptr<N3Node> obj = object();
-			
-			obj = std::move(path(obj.release()));
-			
-			m_sink->triple(*subject, *property, *obj);
+			objectTriple(subject, property);
 			while (m_lookAhead == ',') {
 				match();
 				if (m_lookAhead == Token::PNameLN || m_lookAhead == Token::IriRef || m_lookAhead == Token::BlankNodeLabel || m_lookAhead == Token::PNameNS || m_lookAhead == '{' || m_lookAhead == '[' || m_lookAhead == '(' ||
 				    m_lookAhead == Token::StringLiteralQuote || m_lookAhead == Token::StringLiteralSingleQuote || m_lookAhead == Token::StringLiteralLongSingleQuote || m_lookAhead == Token::StringLiteralLongQuote ||
 				    m_lookAhead == Token::True || m_lookAhead == Token::False || m_lookAhead == Token::Integer || m_lookAhead == Token::Decimal || m_lookAhead == Token::Double) {
-					std::unique_ptr<N3Node> obj = object();
-					
-					obj = std::move(path(obj.release()));
-					
-					m_sink->triple(*subject, *property, *obj);
+					objectTriple(subject, property);
 				} else
 					throw ParseException("expected object after ','", line());
 			}
@@ -487,6 +490,44 @@ namespace n3 {
 			throw ParseException("expected object", line());
 	}
 	
+	void Parser::objectTriple(const N3Node *subject, const Resource *property)
+	{
+		if (m_lookAhead == '{' && m_streamFormulas && m_sink->streamsFormulas() && property->isURIResource()) {
+			const std::string &uri = static_cast<const URIResource *>(property)->uri();
+			if (uri == LOG::implies.uri() || uri == LOG::reverseImplies.uri()) {
+				streamFormula(subject, property);
+				return;
+			}
+		}
+		
+		std::unique_ptr<N3Node> obj = object();
+		
+		obj = std::move(path(obj.release()));
+		
+		m_sink->triple(*subject, *property, *obj);
+	}
+	
+	void Parser::streamFormula(const N3Node *subject, const Resource *property)
+	{
+		std::unique_ptr<GraphTemplate> graph(new GraphTemplate(std::to_string(++m_graphs)));
+		
+		m_streamed = Streamed { subject, property, false };
+		formula(graph.get(), true);
+		
+		if (!m_streamed.begun) {
+			// a small formula is still complete, it is an ordinary object, possibly followed by a path
+			std::unique_ptr<N3Node> obj = path(graph.release());
+			m_sink->triple(*subject, *property, *obj);
+			
+			return;
+		}
+		
+		if (m_lookAhead == '^' || m_lookAhead == '!')
+			throw ParseException("a path can not follow a streamed formula of more than " + std::to_string(STREAM_THRESHOLD) + " triples", line());
+		
+		m_sink->endFormula();
+	}
+	
 	std::unique_ptr<N3Node> Parser::object(GraphTemplate *graph)
 	{
 		if (m_lookAhead == Token::BlankNodeLabel) {
@@ -495,26 +536,24 @@ namespace n3 {
 		} else if (m_lookAhead == Token::PNameLN || m_lookAhead == Token::IriRef || m_lookAhead == Token::PNameNS) {
 			return std::unique_ptr<N3Node>(new URIResource(iri()));
 		} else if (m_lookAhead == Token::StringLiteralQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::StringLiteralLongQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::Integer) {
 			match();
-			return std::unique_ptr<Literal>(new IntegerLiteral(m_lexeme));
+			return integer(m_lexeme);
 		} else if (m_lookAhead == Token::Decimal) {
 			match();
-			return std::unique_ptr<Literal>(new DecimalLiteral(m_lexeme));
+			return decimal(m_lexeme);
 		} else if (m_lookAhead == Token::Double) {
 			match();
-			return std::unique_ptr<Literal>(new DoubleLiteral(m_lexeme));
+			return doubleLiteral(m_lexeme);
 		} else if (m_lookAhead == Token::True) {
 			match();
-			return std::unique_ptr<Literal>(new BooleanLiteral(m_lexeme));
+			return boolean(m_lexeme);
 		} else if (m_lookAhead == Token::False) {
 			match();
-			return std::unique_ptr<Literal>(new BooleanLiteral(m_lexeme));
+			return boolean(m_lexeme);
 		} else if (m_lookAhead == '{') {
 			return graphTemplate();
 		} else if (m_lookAhead == '[') {
@@ -522,11 +561,9 @@ namespace n3 {
 		} else if (m_lookAhead == '(') {
 			return collection(graph);
 		} else if (m_lookAhead == Token::StringLiteralSingleQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else if (m_lookAhead == Token::StringLiteralLongSingleQuote) {
-			match();
-			return dtlang(extractString(m_lexeme));
+			return dtlang(matchString());
 		} else {
 			throw ParseException("expected blank node, iri, literal or list", line());
 		}
@@ -539,24 +576,83 @@ namespace n3 {
 			return std::unique_ptr<Literal>(new StringLiteral(std::move(lexicalValue), m_lexeme.substr(1)));
 		} else if (m_lookAhead == Token::CaretCaret) {
 			match();
-			std::string type = iri();
-			if (type == IntegerLiteral::TYPE)
-				return std::unique_ptr<Literal>(new IntegerLiteral(lexicalValue)); //TODO valid check
-			if (type == DecimalLiteral::TYPE)
-				return std::unique_ptr<Literal>(new DecimalLiteral(lexicalValue));
-			if (type == BooleanLiteral::TYPE)
-				return std::unique_ptr<Literal>(new BooleanLiteral(lexicalValue));
-			if (type == DoubleLiteral::TYPE)
-				return std::unique_ptr<Literal>(new DoubleLiteral(lexicalValue));
-			if (type == StringLiteral::TYPE)
-				return std::unique_ptr<Literal>(new StringLiteral(std::move(lexicalValue)));
-			
-			return std::unique_ptr<Literal>(new OtherLiteral(std::move(lexicalValue), std::move(type)));
+			const Datatypes::Entry &type = datatype(iri());
+			switch (type.kind) {
+				case Datatypes::INTEGER:
+					return integer(lexicalValue);
+				case Datatypes::DECIMAL:
+					return decimal(lexicalValue);
+				case Datatypes::BOOLEAN:
+					return boolean(lexicalValue);
+				case Datatypes::DOUBLE:
+					return doubleLiteral(lexicalValue);
+				case Datatypes::STRING:
+					return std::unique_ptr<Literal>(new StringLiteral(std::move(lexicalValue)));
+				default:
+					return std::unique_ptr<Literal>(new OtherLiteral(std::move(lexicalValue), type));
+			}
 		}
 		
 		return std::unique_ptr<Literal>(new StringLiteral(std::move(lexicalValue)));
 	}
 	
+	const Datatypes::Entry &Parser::datatype(const std::string &iri)
+	{
+		auto i = m_datatypes.find(iri);
+		if (i != m_datatypes.end())
+			return i->second;
+		
+		return m_datatypes.emplace(iri, Datatypes::intern(iri)).first->second;
+	}
+	
+	std::unique_ptr<Literal> Parser::integer(const std::string &lexicalValue)
+	{
+		if (!m_typedValues)
+			return std::unique_ptr<Literal>(new IntegerLiteral(lexicalValue));
+		
+		std::int64_t value;
+		bool big;
+		if (!NumberParser::parseInteger(lexicalValue, value, big))
+			throw ParseException("invalid xsd:integer \"" + lexicalValue + "\"", line());
+		
+		return std::unique_ptr<Literal>(big ? new IntegerLiteral(lexicalValue) : new IntegerLiteral(lexicalValue, value));
+	}
+	
+	std::unique_ptr<Literal> Parser::decimal(const std::string &lexicalValue)
+	{
+		if (!m_typedValues)
+			return std::unique_ptr<Literal>(new DecimalLiteral(lexicalValue));
+		
+		std::int64_t unscaled;
+		unsigned scale;
+		bool big;
+		if (!NumberParser::parseDecimal(lexicalValue, unscaled, scale, big))
+			throw ParseException("invalid xsd:decimal \"" + lexicalValue + "\"", line());
+		
+		return std::unique_ptr<Literal>(big ? new DecimalLiteral(lexicalValue) : new DecimalLiteral(lexicalValue, unscaled, scale));
+	}
+	
+	std::unique_ptr<Literal> Parser::doubleLiteral(const std::string &lexicalValue)
+	{
+		if (!m_typedValues)
+			return std::unique_ptr<Literal>(new DoubleLiteral(lexicalValue));
+		
+		double value;
+		if (!NumberParser::parseDouble(lexicalValue, value))
+			throw ParseException("invalid xsd:double \"" + lexicalValue + "\"", line());
+		
+		return std::unique_ptr<Literal>(new DoubleLiteral(lexicalValue, value));
+	}
+	
+	std::unique_ptr<Literal> Parser::boolean(const std::string &lexicalValue)
+	{
+		bool value;
+		if (m_typedValues && !NumberParser::parseBoolean(lexicalValue, value))
+			throw ParseException("invalid xsd:boolean \"" + lexicalValue + "\"", line());
+		
+		return std::unique_ptr<Literal>(new BooleanLiteral(lexicalValue));
+	}
+	
 	std::unique_ptr<RDFList> Parser::collection(GraphTemplate *graph)
 	{
 		std::unique_ptr<RDFList> list(new RDFList());
@@ -611,36 +707,62 @@ namespace n3 {
 	{
 		std::unique_ptr<GraphTemplate> graph(new GraphTemplate(std::to_string(++m_graphs)));
 		
+		formula(graph.get(), false);
+		
+		return graph;
+	}
+	
+	void Parser::formula(GraphTemplate *graph, bool stream)
+	{
 		match('{');
 		
 		while (m_lookAhead != '}') {
 			if (m_lookAhead == Token::Var || m_lookAhead == Token::PNameLN || m_lookAhead == Token::IriRef || m_lookAhead == Token::BlankNodeLabel || m_lookAhead == Token::PNameNS || m_lookAhead == '{' || m_lookAhead == '(' || 
 			    m_lookAhead == Token::StringLiteralQuote || m_lookAhead == Token::StringLiteralSingleQuote || m_lookAhead == Token::StringLiteralLongSingleQuote || m_lookAhead == Token::StringLiteralLongQuote ||
 			    m_lookAhead == Token::True || m_lookAhead == Token::False || m_lookAhead == Token::Integer || m_lookAhead == Token::Decimal || m_lookAhead == Token::Double) {
-				std::unique_ptr<N3Node> s = subjectorvar(graph.get());
+				std::unique_ptr<N3Node> s = subjectorvar(graph);
 				
-				s = std::move(path(s.release(), graph.get()));
+				s = std::move(path(s.release(), graph));
 				
-				propertylistvar(graph.get(), s.get());
+				propertylistvar(graph, s.get());
 				
 				if (m_lookAhead == '.')
 					match();
+				if (stream)
+					flush(graph);
 			} else if (m_lookAhead == '[') {
-				std::unique_ptr<N3Node> s = blanknodepropertylistvar(graph.get());
+				std::unique_ptr<N3Node> s = blanknodepropertylistvar(graph);
 				
-				s = std::move(path(s.release(), graph.get()));
+				s = std::move(path(s.release(), graph));
 				
-				propertylistoptvar(graph.get(), s.get());
+				propertylistoptvar(graph, s.get());
 				
 				if (m_lookAhead == '.')
 					match();
+				if (stream)
+					flush(graph);
 			} else
 				throw ParseException("expected triple or '}'", line());
 		}
 		
 		match('}');
+	}
+	
+	void Parser::flush(GraphTemplate *graph)
+	{
+		if (!m_streamed.begun) {
+			if (graph->size() < STREAM_THRESHOLD)
+				return;
+			
+			GraphTemplate head(graph->id());
+			m_sink->beginFormula(*m_streamed.subject, *m_streamed.property, head);
+			m_streamed.begun = true;
+		}
 		
-		return graph;
+		for (const TriplePattern &t : static_cast<const GraphTemplate &>(*graph))
+			m_sink->formulaTriple(t.subject(), t.property(), t.object());
+		
+		graph->clear();
 	}
 	
 	void Parser::propertylistvar(GraphTemplate *graph, const N3Node *subject)
@@ -703,7 +825,7 @@ namespace n3 {
 	void Parser::addTriple(GraphTemplate *graph, const N3Node *subject, const Resource *property)
 	{
 		if (m_lookAhead == '[') { // this hack rearanges the order of some triples for performance reasons
-			graph->triple(*subject, *property, BlankNode(""));
+			graph->triple(std::unique_ptr<N3Node>(subject->clone()), std::unique_ptr<N3Node>(property->clone()), nullptr);
 			
 			std::size_t p = graph->size() - 1;
 			
@@ -711,13 +833,13 @@ namespace n3 {
 		
 			obj = std::move(path(obj.release(), graph));
 			
-			(*graph)[p].object(*obj);
+			graph->mutableTriples()[p].object(std::move(obj));
 		} else {
 			std::unique_ptr<N3Node> obj = objectorvar(graph);
 		
 			obj = std::move(path(obj.release(), graph));
 		
-			graph->triple(*subject, *property, *obj);
+			graph->triple(std::unique_ptr<N3Node>(subject->clone()), std::unique_ptr<N3Node>(property->clone()), std::move(obj));
 		}
 	}
 	
@@ -741,7 +863,7 @@ namespace n3 {
 	void Parser::addTriple(GraphTemplate *graph, const N3Node *subject, const Var *property)
 	{
 		if (m_lookAhead == '[') { // this hack rearanges the order of some triples for performance reasons
-			graph->triple(*subject, *property, BlankNode(""));
+			graph->triple(std::unique_ptr<N3Node>(subject->clone()), std::unique_ptr<N3Node>(property->clone()), nullptr);
 			
 			std::size_t p = graph->size() - 1;
 			
@@ -749,13 +871,13 @@ namespace n3 {
 			
 			obj = std::move(path(obj.release(), graph));
 			
-			(*graph)[p].object(*obj);
+			graph->mutableTriples()[p].object(std::move(obj));
 		} else {
 			std::unique_ptr<N3Node> obj = objectorvar(graph);
 			
 			obj = std::move(path(obj.release(), graph));
 			
-			graph->triple(*subject, *property, *obj);
+			graph->triple(std::unique_ptr<N3Node>(subject->clone()), std::unique_ptr<N3Node>(property->clone()), std::move(obj));
 		}
 	}
 	
@@ -787,192 +909,181 @@ namespace n3 {
 		return object(graph);
 	}
 	
-	std::string Parser::unescape(std::size_t start, const std::string &localName)
+	void Parser::unescape(const std::string &localName, std::size_t start, std::string &uri)
 	{
-		std::size_t end = localName.length();
-		
-		if (localName.find('\\', start) == std::string::npos)
-			return localName.substr(start, end - start);
-		
-		std::string buf;
-		
-		buf.reserve(end - start);
+		const char *p   = localName.data() + start;
+		const char *end = localName.data() + localName.length();
 		
-		for (std::size_t i = start; i < end; i++) {
-			char c = localName[i];
+		const char *escape;
+		while ((escape = static_cast<const char *>(std::memchr(p, '\\', end - p)))) {
+			uri.append(p, escape);
 			
-			if (c == '\\') {
-				c = localName[++i];
-				if (LOCAL_NAME_ESCAPE_CHARS.find(c) != std::string::npos)
-					buf.push_back(c);
-				else
-					throw ParseException("\"" + localName + "\" contains illegal escape \"\\" + c + "\"");
-			} else {
-				buf.push_back(c);
-			}
+			char c = escape[1];
+			if (!LOCAL_NAME_ESCAPE[static_cast<unsigned char>(c)])
+				throw ParseException("\"" + localName + "\" contains illegal escape \"\\" + c + "\"");
+			
+			uri.push_back(c);
+			p = escape + 2;
 		}
 		
-		return buf;
+		uri.append(p, end);
 	}
 	
-	std::string Parser::extractUri(const std::string &uriLiteral)
+	void Parser::extractUri(const char *text, std::size_t length, std::string &uri)
 	{
-		if (uriLiteral.find('\\', 1) == std::string::npos)
-			return uriLiteral.substr(1, uriLiteral.length() - 2);
+		const char *p   = text + 1;
+		const char *end = text + length - 1;
 		
-		std::string buf;
-		buf.reserve(uriLiteral.length());
-		auto inserter = std::back_inserter(buf);
+		const char *escape = static_cast<const char *>(std::memchr(p, '\\', end - p));
+		
+		if (!escape) {
+			uri.assign(p, end);
+			return;
+		}
+		
+		uri.clear();
+		uri.reserve(end - p);
 		
 		std::uint16_t highSurrogate = 0;
 		
-		for (auto i = uriLiteral.begin() + 1; i < uriLiteral.end() - 1;) {
-			char c = *i;
-			
-			if (c == '\\') {
-				++i;
-				c = *i;
-				switch (c) {
-					case 'u' : {
-						auto begin = ++i; i += 4; 
-						std::string value = std::string(begin, i);
-						int v = std::stoi(value, nullptr, 16);
-							
-						if (utf16::isHighSurrogate(v)) {
-							if (highSurrogate)
-								throw ParseException("\"" + uriLiteral + "\" contains an unpaired surrogate");
-							
-							highSurrogate = v;
-						} else {
-							
-							if (utf16::isLowSurrogate(v)) {
-								if (!highSurrogate)
-									throw ParseException("\"" + uriLiteral + "\" contains an unpaired surrogate");
-								
-								v = utf16::toChar(highSurrogate, v);
-								utf8::encode(v, inserter);
-								highSurrogate = 0;
-							} else {
-								if (v <= 0x20 || (v < 128 && INVALID_ESCAPES.find(std::string::traits_type::to_char_type(v)) != std::string::npos))
-									throw ParseException("\"" + uriLiteral + "\" contains illegal escape \"\\u" + value + "\"");
-								
-								utf8::encode(v, inserter);
-							}
-						}
+		while (escape) {
+			if (highSurrogate && (escape != p || escape[1] != 'u'))
+				throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+			
+			uri.append(p, escape);
+			
+			char c = escape[1];
+			p = escape + 2;
+			
+			switch (c) {
+				case 'u' : {
+					char32_t v = hex(p, 4);
+					
+					if (utf16::isHighSurrogate(v)) {
+						if (highSurrogate)
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
 						
-						break;
-					}
-					case 'U' : {
+						highSurrogate = v;
+					} else if (utf16::isLowSurrogate(v)) {
+						if (!highSurrogate)
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+						
+						utf8::encode(utf16::toChar(highSurrogate, v), std::back_inserter(uri));
+						highSurrogate = 0;
+					} else {
 						if (highSurrogate)
-							throw ParseException("\"" + uriLiteral + "\" contains an unpaired surrogate");
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
 						
-						auto begin = ++i; i += 8;
-						std::string value = std::string(begin, i);
-						int v = std::stoi(value, nullptr, 16);
-						if (v <= 0x20 || (v < 128 && INVALID_ESCAPES.find(std::string::traits_type::to_char_type(v)) != std::string::npos))
-							throw ParseException("\"" + uriLiteral + "\" contains illegal escape \"\\U" + value + "\"");
-						utf8::encode(v, inserter);
-						break;
+						if (v < 256 && INVALID_ESCAPE[v])
+							throw ParseException("\"" + std::string(text, length) + "\" contains illegal escape \"\\u" + std::string(p, 4) + "\"");
+						
+						utf8::encode(v, std::back_inserter(uri));
 					}
-					default  :
-						throw ParseException("\"" + uriLiteral + "\" contains illegal escape \"\\" + c + "\"");
+					
+					p += 4;
+					break;
 				}
-			} else {
-				if (highSurrogate)
-					throw ParseException("\"" + uriLiteral + "\" contains an unpaired surrogate");
-				inserter = c; // this will actually append c to buf;
-				++i;
+				case 'U' : {
+					char32_t v = hex(p, 8);
+					
+					if (v < 256 && INVALID_ESCAPE[v])
+						throw ParseException("\"" + std::string(text, length) + "\" contains illegal escape \"\\U" + std::string(p, 8) + "\"");
+					
+					utf8::encode(v, std::back_inserter(uri));
+					
+					p += 8;
+					break;
+				}
+				default  :
+					throw ParseException("\"" + std::string(text, length) + "\" contains illegal escape \"\\" + c + "\"");
 			}
+			
+			escape = static_cast<const char *>(std::memchr(p, '\\', end - p));
 		}
 		
-		return buf;
+		if (highSurrogate)
+			throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+		
+		uri.append(p, end);
 	}
 	
-	std::string Parser::extractString(const std::string &stringLiteral)
+	void Parser::extractString(const char *text, std::size_t length, std::size_t quotes, std::string &value)
 	{
-		// Because of the lexer produced stringLiteral, we can assume that the its value is "well formed":
+		// Because the lexer produced text, we can assume that its value is "well formed":
 		// enclosed in matched quotes, escapes are valid, indexes will never go outside the string bounds...
-		std::size_t start;
-		std::size_t end;
+		const char *p   = text + quotes;
+		const char *end = text + length - quotes;
 		
-		if (stringLiteral.find("\"\"\"") == 0 || stringLiteral.find("'''") == 0) {
-			start = 3;
-			end   = stringLiteral.length() - 3;
-		} else {
-			start = 1;
-			end   = stringLiteral.length() - 1;
-		}
+		const char *escape = static_cast<const char *>(std::memchr(p, '\\', end - p));
 		
-		if (stringLiteral.find('\\', start) == std::string::npos)
-			return stringLiteral.substr(start, end - start);
+		if (!escape) {
+			value.assign(p, end);
+			return;
+		}
 		
-		std::string buf;
-		buf.reserve(end - start);
+		value.clear();
+		value.reserve(end - p);
 		
 		std::uint16_t highSurrogate = 0;
 		
-		for (std::size_t i = start; i < end; i++) {
-			char c = stringLiteral[i];
+		while (escape) {
+			if (highSurrogate && (escape != p || escape[1] != 'u'))
+				throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
 			
-			if (c == '\\') {
-				c = stringLiteral[++i];
-				
-				if (highSurrogate && c != 'u')
-					throw ParseException("\"" + stringLiteral + "\" contains an unpaired surrogate");
-				
-				switch (c) {
-					case 'n' : buf.push_back('\n'); break;
-					case 'r' : buf.push_back('\r'); break;
-					case 't' : buf.push_back('\t'); break;
-					case 'f' : buf.push_back('\f'); break;
-					case 'b' : buf.push_back('\b'); break; // backspace, "\u0008"
-					case '"' : buf.push_back('"');  break;
-					case '\'': buf.push_back('\''); break;
-					case '\\': buf.push_back('\\'); break;
-					case 'u' : {
-						std::size_t begin = ++i; i += 3; 
-						std::string value = stringLiteral.substr(begin, 4);
-						int v = std::stoi(value, nullptr, 16);
+			value.append(p, escape);
+			
+			char c = escape[1];
+			p = escape + 2;
+			
+			switch (c) {
+				case 'n' : value.push_back('\n'); break;
+				case 'r' : value.push_back('\r'); break;
+				case 't' : value.push_back('\t'); break;
+				case 'f' : value.push_back('\f'); break;
+				case 'b' : value.push_back('\b'); break; // backspace, "\u0008"
+				case '"' : value.push_back('"');  break;
+				case '\'': value.push_back('\''); break;
+				case '\\': value.push_back('\\'); break;
+				case 'u' : {
+					char32_t v = hex(p, 4);
+					p += 4;
+					
+					if (utf16::isHighSurrogate(v)) {
+						if (highSurrogate)
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
 						
-						if (utf16::isHighSurrogate(v)) {
-							if (highSurrogate)
-								throw ParseException("\"" + stringLiteral + "\" contains an unpaired surrogate");
-								
-							highSurrogate = v;
-						} else {
-							if (utf16::isLowSurrogate(v)) {
-								if (!highSurrogate)
-									throw ParseException("\"" + stringLiteral + "\" contains an unpaired surrogate");
-								
-								v = utf16::toChar(highSurrogate, v);
-								utf8::encode(v, std::back_inserter(buf));
-								highSurrogate = 0;
-							} else {
-								utf8::encode(v, std::back_inserter(buf));
-							}
-						}
-						break;
-					}
-					case 'U' : {
-						std::size_t begin = ++i; i += 7;
-						std::string value = stringLiteral.substr(begin, 8);
-						int v = std::stoi(value, nullptr, 16);
-						utf8::encode(v, std::back_inserter(buf));
-						break;
+						highSurrogate = v;
+					} else if (utf16::isLowSurrogate(v)) {
+						if (!highSurrogate)
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+						
+						utf8::encode(utf16::toChar(highSurrogate, v), std::back_inserter(value));
+						highSurrogate = 0;
+					} else {
+						if (highSurrogate)
+							throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+						
+						utf8::encode(v, std::back_inserter(value));
 					}
-					
-					default  :
-						throw ParseException(stringLiteral + " contains \"\\" + c + "\"");
+					break;
+				}
+				case 'U' : {
+					utf8::encode(hex(p, 8), std::back_inserter(value));
+					p += 8;
+					break;
 				}
-			} else {
-				if (highSurrogate)
-					throw ParseException("\"" + stringLiteral + "\" contains an unpaired surrogate");
 				
-				buf.push_back(c);
+				default  :
+					throw ParseException(std::string(text, length) + " contains \"\\" + c + "\"");
 			}
+			
+			escape = static_cast<const char *>(std::memchr(p, '\\', end - p));
 		}
 		
-		return buf;
+		if (highSurrogate)
+			throw ParseException("\"" + std::string(text, length) + "\" contains an unpaired surrogate");
+		
+		value.append(p, end);
 	}
 	
 }
@@ -18,15 +18,20 @@
 #define CARL_PARSER_H
 
 #include <cstddef>
+#include <cstdint>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <FlexLexer.h>
 
 #include "Uri.hh"
 #include "Token.hh"
 #include "Model.hh"
 #include "BlankNodeIdGenerator.hh"
+#include "Memory.hh"
+#include "Hash.hh"
 
 namespace n3 {
 	
@@ -35,6 +40,15 @@ namespace n3 {
 	public:
 		explicit ParseException(const std::string &message = std::string(), int line = -1) : std::runtime_error(message), m_line(line) {}
 		int line() const noexcept { return m_line; }
+		
+		/// The message as reported to the user, including the line number when known.
+		std::string report() const
+		{
+			if (m_line == -1)
+				return std::string("parse error: ") + what();
+			
+			return "parse error at line " + std::to_string(m_line) + ": " + what();
+		}
 	};
 	
 	struct TripleSink {
@@ -44,14 +58,29 @@ namespace n3 {
 		virtual void document(const std::string &source) = 0;
 		virtual void prefix(const std::string &prefix, const std::string &ns) = 0;
 		virtual void triple(const N3Node &subject, const N3Node &property, const N3Node &object) = 0;
-		virtual unsigned count() const = 0;
+		virtual std::uint64_t count() const = 0;
+		
+		/// Called after document() when the blank node ids of the document are derived from seed
+		/// (see Parser::deterministic), so a sink naming nodes of its own can derive them too.
+		virtual void deterministic(std::uint64_t seed) {}
+		
+		/// Writes statistics about the output, if any, for diagnostics.
+		virtual void statistics(std::ostream &out) const {}
+		
+		/// True when the sink accepts streamed formulas: beginFormula(s, p, f), formulaTriple() for
+		/// every triple in f and endFormula() have the same result as triple(s, p, f).
+		/// The parser only streams the object formula of top-level rules.
+		virtual bool streamsFormulas() const { return false; }
+		virtual void beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula) {}
+		virtual void formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object) {}
+		virtual void endFormula() {}
 		
 		virtual ~TripleSink() {}
 	};
 	
 	class DefaultTripleSink : public TripleSink {
 	protected:
-		unsigned m_count;
+		std::uint64_t m_count;
 	public:
 		DefaultTripleSink() : TripleSink(), m_count(0) {}
 		virtual void start() override {}
@@ -59,32 +88,92 @@ namespace n3 {
 		virtual void document(const std::string &source) override {}
 		virtual void prefix(const std::string &prefix, const std::string &ns) override {}
 		virtual void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override { ++m_count; }
-		virtual unsigned count() const override { return m_count; }
+		virtual std::uint64_t count() const override { return m_count; }
 	};
 
 	
+	class Lexer : public ::yyFlexLexer {
+	public:
+		explicit Lexer(std::istream *in) : ::yyFlexLexer(in) {}
+		
+		void reset(std::istream *in, int line = 1)
+		{
+			yyrestart(in);
+			yylineno = line;
+		}
+		
+	protected:
+		/// Takes what the stream has buffered, waiting for input only when that is nothing:
+		/// the default waits for max_size bytes, stalling input arriving from a pipe.
+		int LexerInput(char *buf, int max_size) override
+		{
+			if (yyin->eof() || yyin->fail())
+				return 0;
+			
+			std::streamsize n = yyin->readsome(buf, max_size);
+			if (n > 0)
+				return static_cast<int>(n);
+			
+			if (!yyin->get(buf[0]))
+				return yyin->bad() ? -1 : 0;
+			
+			return 1 + static_cast<int>(yyin->readsome(buf + 1, max_size - 1));
+		}
+	};
+	
+	///
+	/// A source of tokens for the parser other than its own lexer, see Pipeline.
+	///
+	struct TokenReader {
+		/// Returns the next token, its text stays valid until the following call.
+		virtual Token::Type next(const char *&text, std::size_t &length, int &line) = 0;
+		virtual ~TokenReader() {}
+	};
+	
 	class Parser {
 		
-		static const std::string LOCAL_NAME_ESCAPE_CHARS;
-		static const std::string INVALID_ESCAPES;
+		static const bool LOCAL_NAME_ESCAPE[];
+		static const bool INVALID_ESCAPE[];
+		static const std::uint8_t HEX_VALUE[];
 		
-		::yyFlexLexer m_lexer;
+		Lexer m_lexer;
+		TokenReader *m_reader; // when set, used instead of m_lexer
+		const char *m_text;    // the text, length and line of the last token from m_reader
+		std::size_t m_length;
+		int m_line;
 		
 		Uri m_base;
 		TripleSink *m_sink;
 		std::map<std::string, std::string> m_prefixMap;
 		
 		BlankNodeIdGenerator m_blanks;
-		unsigned m_graphs;
+		bool m_deterministic;
+		std::uint64_t m_seed;  // of m_blanks when m_deterministic
+		std::unordered_map<std::string, Datatypes::Entry> m_datatypes; // cache of Datatypes::intern for the document
+		std::uint64_t m_graphs;
+		bool m_typedValues;
+		bool m_streamFormulas;
+		
+		// the formula of streamFormula, passed on to the sink once it has STREAM_THRESHOLD triples
+		struct Streamed {
+			const N3Node *subject;
+			const Resource *property;
+			bool begun;
+		} m_streamed;
+		
+		static const std::size_t STREAM_THRESHOLD = 1024;
 		
 		Token::Type m_lookAhead;
 		std::string m_lexeme;
 		
-		Token::Type nextToken() { return m_lexer.yylex(); }
+		Token::Type nextToken() { return m_reader ? m_reader->next(m_text, m_length, m_line) : m_lexer.yylex(); }
+		
+		const char *text() const { return m_reader ? m_text : m_lexer.YYText(); }
+		std::size_t length() const { return m_reader ? m_length : m_lexer.YYLeng(); }
 		
 		void match(Token::Type token)
 		{
-			m_lexeme.assign(m_lexer.YYText(), m_lexer.YYLeng());
+			m_lexeme.assign(text(), length());
 			if (m_lookAhead == token)
 				m_lookAhead = nextToken();
 			else
@@ -93,8 +182,37 @@ namespace n3 {
 
 		void match()
 		{
-			m_lexeme.assign(m_lexer.YYText(), m_lexer.YYLeng());
+			m_lexeme.assign(text(), length());
+			m_lookAhead = nextToken();
+		}
+		
+		/// Matches an IRI reference, its value is decoded straight from the lexer's buffer.
+		std::string matchUri()
+		{
+			if (m_lookAhead != Token::IriRef)
+				throw ParseException("expected different symbol");
+			
+			std::string uri;
+			extractUri(text(), length(), uri);
+			
+			m_lookAhead = nextToken();
+			
+			return uri;
+		}
+		
+		/// Matches a string literal, its value is decoded straight from the lexer's buffer.
+		/// This is the one copy of the value: the literal takes it over by move, as it must
+		/// own its text once the lexer refills the buffer.
+		std::string matchString()
+		{
+			std::size_t quotes = m_lookAhead == Token::StringLiteralLongQuote || m_lookAhead == Token::StringLiteralLongSingleQuote ? 3 : 1;
+			
+			std::string value;
+			extractString(text(), length(), quotes, value);
+			
 			m_lookAhead = nextToken();
+			
+			return value;
 		}
 		
 		Uri resolve(const std::string &uri);
@@ -102,6 +220,19 @@ namespace n3 {
 		std::string toUri(const std::string &pname) const;
 		
 		void n3doc();
+		
+		void statements()
+		{
+			m_lookAhead = nextToken();
+			
+			try {
+				n3doc();
+			} catch (MemoryLimitExceeded &) {
+				Memory::Unlimited unlimited;
+				throw ParseException("memory limit of " + std::to_string(Memory::limit()) + " bytes exceeded", line());
+			}
+		}
+		
 		void base();
 		void prefixID();
 		void sparqlBase();
@@ -112,14 +243,23 @@ namespace n3 {
 		void property(const N3Node *subject);
 		std::string iri();
 		void objectlist(const N3Node *subject, const Resource *property);
+		void objectTriple(const N3Node *subject, const Resource *property);
+		void streamFormula(const N3Node *subject, const Resource *property);
 		std::unique_ptr<N3Node> object(GraphTemplate *graph = nullptr);
 		std::unique_ptr<Literal> dtlang(std::string &&lexicalValue);
+		const Datatypes::Entry &datatype(const std::string &iri);
+		std::unique_ptr<Literal> integer(const std::string &lexicalValue);
+		std::unique_ptr<Literal> decimal(const std::string &lexicalValue);
+		std::unique_ptr<Literal> doubleLiteral(const std::string &lexicalValue);
+		std::unique_ptr<Literal> boolean(const std::string &lexicalValue);
 		std::unique_ptr<RDFList> collection(GraphTemplate *graph);
 		std::unique_ptr<BlankNode> blanknodepropertylist();
 		std::unique_ptr<BlankNode> blanknodepropertylistvar(GraphTemplate *graph);
 		void propertylistopt(const N3Node *subject);
 		void propertylistoptvar(GraphTemplate *graph, const N3Node *subject);
 		std::unique_ptr<GraphTemplate> graphTemplate();
+		void formula(GraphTemplate *graph, bool stream);
+		void flush(GraphTemplate *graph);
 		void propertylistvar(GraphTemplate *graph, const N3Node *subject);
 		void propertyorvar(GraphTemplate *graph, const N3Node *subject);
 		std::unique_ptr<N3Node> subjectorvar(GraphTemplate *graph);
@@ -133,22 +273,88 @@ namespace n3 {
 		std::unique_ptr<N3Node> path(N3Node *subject);
 		std::unique_ptr<N3Node> path(N3Node *subject, GraphTemplate *graph);
 		
-		static std::string unescape(std::size_t start, const std::string &localName);
-		static std::string extractUri(const std::string &uriLiteral);
-		static std::string extractString(const std::string &stringLiteral);
+		/// Appends the local name starting at start to uri, removing its escapes.
+		static void unescape(const std::string &localName, std::size_t start, std::string &uri);
+		static void extractUri(const char *text, std::size_t length, std::string &uri);
+		static void extractString(const char *text, std::size_t length, std::size_t quotes, std::string &value);
+		
+		/// The value of count hexadecimal digits.
+		static char32_t hex(const char *digits, int count)
+		{
+			char32_t v = 0;
+			for (int i = 0; i < count; i++)
+				v = (v << 4) | HEX_VALUE[static_cast<unsigned char>(digits[i])];
+			
+			return v;
+		}
 		
 	public:
-		Parser(std::istream *in, const Uri &base, TripleSink *sink) : m_lexer(in), m_base(base), m_sink(sink), m_prefixMap(), m_blanks(), m_graphs(0), m_lookAhead(0), m_lexeme() {}
+		Parser(std::istream *in, const Uri &base, TripleSink *sink) : m_lexer(in), m_reader(nullptr), m_text(nullptr), m_length(0), m_line(1), m_base(base), m_sink(sink), m_prefixMap(), m_blanks(), m_deterministic(false), m_seed(0), m_datatypes(), m_graphs(0), m_typedValues(false), m_streamFormulas(false), m_streamed(), m_lookAhead(0), m_lexeme() {}
 		
 		void parse()
 		{
 			m_sink->document(static_cast<std::string>(m_base));
-			m_lookAhead = nextToken();
-			
-			n3doc();
+			if (m_deterministic)
+				m_sink->deterministic(m_seed);
+			statements();
+		}
+		
+		/// Parses the statements read from in as the continuation of the document parsed
+		/// before: the base, the prefixes and the blank node labels stay. The first line
+		/// of in is line number line. The statements in every input must be complete.
+		void resume(std::istream *in, int line)
+		{
+			m_lexer.reset(in, line);
+			statements();
+		}
+		
+		/// Prepares the parser for a new document, keeping the allocated lexer and generator state.
+		void reset(std::istream *in, const Uri &base)
+		{
+			m_lexer.reset(in);
+			m_base = base;
+			m_prefixMap.clear();
+			m_datatypes.clear();
+			m_blanks.initialize();
+			m_deterministic = false;
+			m_graphs = 0;
+			m_lookAhead = 0;
+			m_lexeme.clear();
 		}
 
-		int line() const { return m_lexer.lineno(); }
+		int line() const { return m_reader ? m_line : m_lexer.lineno(); }
+		
+		/// Derives the blank node ids of the document from a hash of its content and the base
+		/// instead of drawing them at random, so translating the same document with the same
+		/// base gives the same output. When the base is not the document's own, like with -b,
+		/// pass the uri or path of the document as name: documents with the same content and
+		/// base then still get different ids. Call after construction or reset().
+		void deterministic(std::uint64_t contentHash, const std::string &name = std::string())
+		{
+			Hash64 hash;
+			hash.update(Hash64::toHex(contentHash));
+			hash.update(static_cast<std::string>(m_base));
+			if (!name.empty()) {
+				hash.update("", 1); // a uri has no NUL, base and name can not run together
+				hash.update(name);
+			}
+			
+			m_deterministic = true;
+			m_seed = hash.value();
+			m_blanks.initialize(m_seed);
+		}
+		
+		/// Reads the tokens from reader instead of the input stream.
+		void tokens(TokenReader *reader) { m_reader = reader; }
+		
+		/// When set, numeric and boolean literals carry their parsed value and invalid lexical forms are rejected.
+		void typedValues(bool typedValues) { m_typedValues = typedValues; }
+		bool typedValues() const { return m_typedValues; }
+		
+		/// When set and the sink supports it, the object formula of top-level rules is streamed
+		/// to the sink statement by statement instead of being built first.
+		void streamFormulas(bool streamFormulas) { m_streamFormulas = streamFormulas; }
+		bool streamFormulas() const { return m_streamFormulas; }
 	};
 
 }
@@ -0,0 +1,314 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Pipeline.hh"
+#include "SpscRing.hh"
+#include "Event.hh"
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		struct TokenBatch {
+			
+			struct Entry {
+				Token::Type type;
+				std::size_t offset; // in text
+				std::size_t length;
+				int line;
+			};
+			
+			std::vector<Entry> tokens;
+			std::string text;
+			bool last;
+			std::exception_ptr error;
+			
+			TokenBatch() : tokens(), text(), last(false), error() {}
+			
+			void clear()
+			{
+				tokens.clear();
+				text.clear();
+				last = false;
+				error = nullptr;
+			}
+		};
+		
+		struct EventBatch {
+			std::vector<Event> events;
+			bool last;
+			std::exception_ptr error;
+			
+			EventBatch() : events(), last(false), error() {}
+			
+			void clear()
+			{
+				events.clear();
+				last = false;
+				error = nullptr;
+			}
+		};
+		
+		typedef SpscRing<TokenBatch, Pipeline::RING_SIZE> TokenRing;
+		typedef SpscRing<EventBatch, Pipeline::RING_SIZE> EventRing;
+		
+		/// Thrown in a stage when a later stage stopped.
+		struct Cancelled {};
+		
+		void lexInput(std::istream *in, TokenRing &ring)
+		{
+			Lexer lexer(in);
+			
+			for (;;) {
+				TokenBatch *batch = ring.acquire();
+				if (!batch)
+					return;
+				
+				batch->clear();
+				try {
+					while (batch->tokens.size() < Pipeline::TOKEN_BATCH_SIZE) {
+						Token::Type type = lexer.yylex();
+						
+						batch->tokens.push_back(TokenBatch::Entry { type, batch->text.length(), static_cast<std::size_t>(lexer.YYLeng()), lexer.lineno() });
+						batch->text.append(lexer.YYText(), lexer.YYLeng());
+						
+						if (type == Token::Eof) {
+							batch->last = true;
+							break;
+						}
+					}
+				} catch (...) {
+					batch->error = std::current_exception();
+					batch->last = true;
+				}
+				
+				bool last = batch->last;
+				ring.publish();
+				
+				if (last)
+					return;
+			}
+		}
+		
+		class RingTokenReader : public TokenReader {
+			
+			TokenRing &m_ring;
+			TokenBatch *m_batch;
+			std::size_t m_next;
+			
+		public:
+			explicit RingTokenReader(TokenRing &ring) : TokenReader(), m_ring(ring), m_batch(nullptr), m_next(0) {}
+			
+			Token::Type next(const char *&text, std::size_t &length, int &line) override
+			{
+				if (m_batch && m_next == m_batch->tokens.size()) {
+					if (m_batch->last) // keep returning Eof
+						--m_next;
+					else {
+						m_ring.release();
+						m_batch = nullptr;
+					}
+				}
+				
+				if (!m_batch) {
+					m_batch = m_ring.peek();
+					if (!m_batch)
+						throw Cancelled();
+					if (m_batch->error)
+						std::rethrow_exception(m_batch->error);
+					m_next = 0;
+				}
+				
+				const TokenBatch::Entry &token = m_batch->tokens[m_next++];
+				text   = m_batch->text.data() + token.offset;
+				length = token.length;
+				line   = token.line;
+				
+				return token.type;
+			}
+		};
+		
+		class EventRecorder : public TripleSink {
+			
+			EventRing &m_ring;
+			EventBatch *m_batch;
+			bool m_streamsFormulas;
+			
+			void add(Event &&event)
+			{
+				if (!m_batch) {
+					m_batch = m_ring.acquire();
+					if (!m_batch)
+						throw Cancelled();
+					m_batch->clear();
+				}
+				
+				m_batch->events.push_back(std::move(event));
+			}
+			
+			void flush()
+			{
+				if (m_batch->events.size() >= Pipeline::EVENT_BATCH_SIZE) {
+					m_ring.publish();
+					m_batch = nullptr;
+				}
+			}
+			
+		public:
+			EventRecorder(EventRing &ring, bool streamsFormulas) : TripleSink(), m_ring(ring), m_batch(nullptr), m_streamsFormulas(streamsFormulas) {}
+			
+			void start() override {}
+			void end() override {}
+			std::uint64_t count() const override { return 0; }
+			
+			void document(const std::string &source) override
+			{
+				add(Event(Event::DOCUMENT, source));
+				flush();
+			}
+			
+			void deterministic(std::uint64_t seed) override
+			{
+				add(Event(Event::DETERMINISTIC, seed));
+				flush();
+			}
+			
+			void prefix(const std::string &prefix, const std::string &ns) override
+			{
+				add(Event(Event::PREFIX, prefix, ns));
+				flush();
+			}
+			
+			void triple(const N3Node &subject, const N3Node &property, const N3Node &object) override
+			{
+				add(Event(Event::TRIPLE, subject, property, &object));
+				flush();
+			}
+			
+			bool streamsFormulas() const override { return m_streamsFormulas; }
+			
+			void beginFormula(const N3Node &subject, const N3Node &property, const GraphTemplate &formula) override
+			{
+				add(Event(Event::BEGIN_FORMULA, subject, property, &formula));
+				flush();
+			}
+			
+			void formulaTriple(const N3Node &subject, const N3Node &property, const N3Node &object) override
+			{
+				add(Event(Event::FORMULA_TRIPLE, subject, property, &object));
+				flush();
+			}
+			
+			void endFormula() override
+			{
+				add(Event(Event::END_FORMULA));
+				flush();
+			}
+			
+			/// Publishes the last batch, with error if not null.
+			void finish(std::exception_ptr error)
+			{
+				if (!m_batch) {
+					m_batch = m_ring.acquire();
+					if (!m_batch)
+						return;
+					m_batch->clear();
+				}
+				
+				m_batch->last  = true;
+				m_batch->error = error;
+				m_ring.publish();
+				m_batch = nullptr;
+			}
+		};
+		
+		void parseTokens(TokenRing &tokens, EventRing &events, const Uri &base, bool streamsFormulas, bool typedValues, bool streamFormulas, Optional<std::uint64_t> contentHash, const std::string &name)
+		{
+			EventRecorder recorder(events, streamsFormulas);
+			
+			try {
+				RingTokenReader reader(tokens);
+				
+				Parser parser(nullptr, base, &recorder);
+				parser.tokens(&reader);
+				parser.typedValues(typedValues);
+				parser.streamFormulas(streamFormulas);
+				if (contentHash)
+					parser.deterministic(*contentHash, name);
+				parser.parse();
+			} catch (Cancelled &) {
+				tokens.cancel();
+				events.cancel();
+				return;
+			} catch (...) {
+				tokens.cancel();
+				recorder.finish(std::current_exception());
+				return;
+			}
+			
+			recorder.finish(nullptr);
+		}
+	}
+	
+	void Pipeline::parse(std::istream *in, const Uri &base)
+	{
+		std::unique_ptr<TokenRing> tokens(new TokenRing());
+		std::unique_ptr<EventRing> events(new EventRing());
+		
+		std::thread lexer(lexInput, in, std::ref(*tokens));
+		std::thread parser(parseTokens, std::ref(*tokens), std::ref(*events), std::cref(base), m_sink->streamsFormulas(), m_typedValues, m_streamFormulas, m_contentHash, std::cref(m_name));
+		
+		std::exception_ptr error;
+		try {
+			for (;;) {
+				EventBatch *batch = events->peek();
+				if (!batch)
+					break;
+				
+				for (const Event &event : batch->events)
+					event.replay(*m_sink);
+				
+				error = batch->error;
+				bool last = batch->last;
+				
+				batch->clear();
+				events->release();
+				
+				if (last)
+					break;
+			}
+		} catch (...) {
+			error = std::current_exception();
+			tokens->cancel();
+			events->cancel();
+		}
+		
+		parser.join();
+		lexer.join();
+		
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+}
@@ -0,0 +1,69 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_PIPELINE_HH
+#define CARL_PIPELINE_HH
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "Optional.hh"
+#include "Parser.hh"
+#include "Uri.hh"
+
+namespace n3 {
+	
+	///
+	/// Translates a document on three threads: one lexes the input into batches of tokens,
+	/// one parses those into batches of events and the calling thread replays the events
+	/// to the sink. The stages are connected by SpscRings.
+	///
+	/// The result is the same as that of Parser, a ParseException is thrown on the calling thread.
+	///
+	class Pipeline {
+		
+		TripleSink *m_sink;
+		bool m_typedValues;
+		bool m_streamFormulas;
+		Optional<std::uint64_t> m_contentHash;
+		std::string m_name;
+		
+	public:
+		static const std::size_t TOKEN_BATCH_SIZE = 4096;
+		static const std::size_t EVENT_BATCH_SIZE = 1024;
+		static const std::size_t RING_SIZE = 8;
+		
+		explicit Pipeline(TripleSink *sink) : m_sink(sink), m_typedValues(false), m_streamFormulas(false), m_contentHash(), m_name() {}
+		
+		/// See Parser::typedValues and Parser::streamFormulas.
+		void typedValues(bool typedValues) { m_typedValues = typedValues; }
+		void streamFormulas(bool streamFormulas) { m_streamFormulas = streamFormulas; }
+		
+		/// See Parser::deterministic, applies to the next document parsed.
+		void deterministic(std::uint64_t contentHash, const std::string &name = std::string())
+		{
+			m_contentHash = contentHash;
+			m_name = name;
+		}
+		
+		void parse(std::istream *in, const Uri &base);
+	};
+
+}
+
+#endif /* CARL_PIPELINE_HH */
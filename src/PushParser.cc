@@ -0,0 +1,174 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "PushParser.hh"
+
+#include <algorithm>
+
+
+namespace n3 {
+	
+	PushParser::PushParser(const Uri &base, TripleSink *sink)
+		: m_inbuf(), m_in(&m_inbuf), m_parser(&m_in, base, sink), m_started(false),
+		  m_buffer(), m_scanned(0), m_end(0), m_line(1), m_state(NORMAL), m_quote(0), m_quotes(0), m_depth(0)
+	{
+	}
+	
+	void PushParser::scan()
+	{
+		for (; m_scanned < m_buffer.size(); ++m_scanned) {
+			char c = m_buffer[m_scanned];
+			
+			switch (m_state) {
+				case LESS:
+					if (c == '=') {
+						m_state = NORMAL;
+						continue;
+					}
+					m_state = IRI;
+					/* fall through */
+				case IRI:
+					if (c == '>') {
+						m_state = NORMAL;
+						continue;
+					}
+					if (static_cast<unsigned char>(c) > 0x20 && c != '<' && c != '"' && c != '{' && c != '}' && c != '|' && c != '^' && c != '`')
+						continue;
+					m_state = NORMAL; // not an IRI, scan c again
+					break;
+				case QUOTE:
+					if (c == m_quote) {
+						m_state = QUOTE2;
+						continue;
+					}
+					m_state = STRING;
+					/* fall through */
+				case STRING:
+					if (c == m_quote || c == '\n' || c == '\r')
+						m_state = NORMAL;
+					else if (c == '\\')
+						m_state = STRING_ESCAPE;
+					continue;
+				case STRING_ESCAPE:
+					m_state = STRING;
+					continue;
+				case QUOTE2:
+					if (c == m_quote) {
+						m_state = LONG_STRING;
+						m_quotes = 0;
+						continue;
+					}
+					m_state = NORMAL; // an empty string
+					break;
+				case LONG_STRING:
+					if (c == m_quote) {
+						if (++m_quotes == 3)
+							m_state = NORMAL;
+					} else {
+						m_quotes = 0;
+						if (c == '\\')
+							m_state = LONG_STRING_ESCAPE;
+					}
+					continue;
+				case LONG_STRING_ESCAPE:
+					m_state = LONG_STRING;
+					continue;
+				case COMMENT:
+					if (c == '\n' || c == '\r')
+						m_state = NORMAL;
+					continue;
+				case ESCAPE:
+					m_state = NORMAL;
+					continue;
+				case DOT:
+					m_state = NORMAL;
+					if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '#')
+						m_end = m_scanned;
+					break;
+				case NORMAL:
+					break;
+			}
+			
+			switch (c) {
+				case '<':
+					m_state = LESS;
+					break;
+				case '"':
+				case '\'':
+					m_state = QUOTE;
+					m_quote = c;
+					break;
+				case '#':
+					m_state = COMMENT;
+					break;
+				case '\\':
+					m_state = ESCAPE;
+					break;
+				case '{':
+				case '[':
+				case '(':
+					++m_depth;
+					break;
+				case '}':
+				case ']':
+				case ')':
+					if (m_depth > 0)
+						--m_depth;
+					break;
+				case '.':
+					if (m_depth == 0)
+						m_state = DOT;
+					break;
+			}
+		}
+	}
+	
+	void PushParser::parse(std::size_t size)
+	{
+		m_inbuf.reset(m_buffer.data(), size);
+		m_in.clear();
+		
+		if (m_started) {
+			m_parser.resume(&m_in, m_line);
+		} else {
+			m_started = true;
+			m_parser.parse();
+		}
+		
+		m_line += static_cast<int>(std::count(m_buffer.data(), m_buffer.data() + size, '\n'));
+		
+		m_buffer.erase(0, size);
+		m_scanned -= size;
+		m_end = 0;
+	}
+	
+	void PushParser::feed(const char *data, std::size_t size)
+	{
+		m_buffer.append(data, size);
+		scan();
+		
+		if (m_end > 0)
+			parse(m_end);
+	}
+	
+	void PushParser::finish()
+	{
+		if (!m_started || !m_buffer.empty())
+			parse(m_buffer.size());
+	}
+
+}
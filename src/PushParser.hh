@@ -0,0 +1,98 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_PUSH_PARSER_HH
+#define CARL_PUSH_PARSER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "Parser.hh"
+#include "Streams.hh"
+#include "Uri.hh"
+
+namespace n3 {
+	
+	///
+	/// Parser for input arriving in pieces, like from a non-blocking socket: feed() the bytes
+	/// as they arrive, split at any byte, and finish() at the end of the input. The triples
+	/// of a statement reach the sink from the feed() that completes the statement.
+	///
+	/// A scanner keeps track of strings, IRIs, comments, escapes and brackets to find the '.' ending
+	/// top-level statements; the complete statements are parsed by a Parser that keeps its
+	/// state (base, prefixes, blank nodes) between them. Only the incomplete statement is
+	/// buffered.
+	///
+	class PushParser {
+		
+		enum State {
+			NORMAL,
+			LESS,        // '<', an IRI or '<='
+			IRI,
+			QUOTE,       // one quote, the start of a string
+			QUOTE2,      // two quotes, an empty string or the start of a long string
+			STRING,
+			STRING_ESCAPE,
+			LONG_STRING,
+			LONG_STRING_ESCAPE,
+			COMMENT,
+			ESCAPE,      // '\\' outside strings, the escape of a local name like ex:a\.
+			DOT          // a '.' at depth 0, the end of a statement when followed by white space
+		};
+		
+		MemoryStreamBuf m_inbuf;
+		std::istream m_in;
+		Parser m_parser;
+		bool m_started;
+		
+		std::string m_buffer;  // the input not parsed yet
+		std::size_t m_scanned; // the bytes of m_buffer scanned
+		std::size_t m_end;     // the end of the last complete statement in m_buffer
+		int m_line;            // the line number of the start of m_buffer
+		
+		State m_state;
+		char m_quote;          // the quote of the string
+		int m_quotes;          // the number of consecutive quotes in a long string
+		int m_depth;           // the number of open brackets, an unbalanced close is left to the parser
+		
+		void scan();
+		void parse(std::size_t size);
+		
+	public:
+		PushParser(const Uri &base, TripleSink *sink);
+		
+		PushParser(const PushParser &) = delete;
+		PushParser &operator=(const PushParser &) = delete;
+		
+		/// Parses the statements completed by data. Throws ParseException.
+		void feed(const char *data, std::size_t size);
+		
+		/// Parses the rest of the input. Throws ParseException.
+		void finish();
+		
+		/// See Parser::typedValues.
+		void typedValues(bool typedValues) { m_parser.typedValues(typedValues); }
+		
+		/// See Parser::deterministic; the input is not known in advance, so seed stands in for its hash.
+		void deterministic(std::uint64_t seed) { m_parser.deterministic(seed); }
+	};
+
+}
+
+#endif /* CARL_PUSH_PARSER_HH */
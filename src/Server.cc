@@ -0,0 +1,261 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Server.hh"
+
+#include <iostream>
+#include <memory>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+
+#include "Translator.hh"
+#include "Streams.hh"
+#include "Frame.hh"
+#include "ThreadPool.hh"
+#include "Memory.hh"
+
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <pthread.h>
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <sys/socket.h>
+#	include <sys/un.h>
+#	include <sys/time.h>
+#endif
+
+namespace n3 {
+	
+	namespace {
+		
+		volatile std::sig_atomic_t stopRequested = 0;
+		
+		void requestStop(int)
+		{
+			stopRequested = 1;
+		}
+		
+		struct Session {
+			Translator translator;
+			
+			explicit Session(const Uri &defaultBase) : translator(defaultBase) {}
+		};
+	}
+	
+	Server::Server(const std::string &path, const Uri &defaultBase, unsigned threads)
+		: m_path(path), m_defaultBase(defaultBase), m_threads(threads), m_deterministic(false),
+		  m_maxRequest(frame::DEFAULT_MAX_REQUEST), m_idleTimeout(DEFAULT_IDLE_TIMEOUT), m_connections(), m_mutex()
+	{
+	}
+	
+	void Server::exchange(std::istream &in, std::ostream &out, Translator &translator, std::size_t maxRequest)
+	{
+		std::string base, document;
+		
+		while (frame::readRequest(in, base, document, maxRequest)) {
+			try {
+				const std::string &n3p = translator.translate(base, document.data(), document.length());
+				frame::writeResponse(out, frame::OK, n3p);
+			} catch (ParseException &e) {
+				frame::writeResponse(out, frame::ERROR, e.report());
+			} catch (std::bad_alloc &e) {
+				Memory::Unlimited unlimited;
+				
+				// answer the request, then close: the translator may be left in any state
+				frame::writeResponse(out, frame::ERROR, e.what());
+				out.flush();
+				throw;
+			}
+			
+			if (!out.flush())
+				break;
+		}
+	}
+
+#ifdef _WIN32
+
+	int Server::run()
+	{
+		std::cerr << "server mode is not supported on this platform" << std::endl;
+		
+		return -1;
+	}
+	
+	void Server::serve(int fd) {}
+	void Server::closeConnections() {}
+
+#else /* !_WIN32 */
+
+	int Server::run()
+	{
+		sockaddr_un address;
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		
+		if (m_path.length() >= sizeof(address.sun_path)) {
+			std::cerr << "socket path \"" << m_path << "\" is too long" << std::endl;
+			
+			return -1;
+		}
+		
+		std::strncpy(address.sun_path, m_path.c_str(), sizeof(address.sun_path) - 1);
+		
+		int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0) {
+			std::cerr << "error creating socket: " << std::strerror(errno) << std::endl;
+			
+			return -1;
+		}
+		
+		// remove a stale socket left behind by a previous server, but not the socket of one still running
+		struct stat st;
+		if (::stat(m_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+			int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (probe < 0) {
+				std::cerr << "error creating socket: " << std::strerror(errno) << std::endl;
+				::close(listener);
+				
+				return -1;
+			}
+			
+			int result = ::connect(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+			int error = errno;
+			::close(probe);
+			
+			if (result == 0) {
+				std::cerr << "error listening on \"" << m_path << "\": address in use" << std::endl;
+				::close(listener);
+				
+				return -1;
+			}
+			
+			if (error == ECONNREFUSED)
+				::unlink(m_path.c_str());
+		}
+		
+		if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listener, SOMAXCONN) < 0) {
+			std::cerr << "error listening on \"" << m_path << "\": " << std::strerror(errno) << std::endl;
+			::close(listener);
+			
+			return -1;
+		}
+		
+		struct sigaction action;
+		std::memset(&action, 0, sizeof(action));
+		action.sa_handler = requestStop; // no SA_RESTART, accept must be interrupted
+		::sigaction(SIGINT, &action, nullptr);
+		::sigaction(SIGTERM, &action, nullptr);
+		
+		std::signal(SIGPIPE, SIG_IGN);
+		
+		std::cerr << "listening on " << m_path << std::endl;
+		
+		// only the accepting thread handles the stop signals
+		sigset_t signals;
+		sigemptyset(&signals);
+		sigaddset(&signals, SIGINT);
+		sigaddset(&signals, SIGTERM);
+		
+		::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+		
+		{
+			ThreadPool pool(m_threads);
+			
+			::pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+			
+			while (!stopRequested) {
+				int fd = ::accept(listener, nullptr, nullptr);
+				if (fd < 0) {
+					if (errno == EINTR || errno == ECONNABORTED)
+						continue;
+					
+					std::cerr << "error accepting connection: " << std::strerror(errno) << std::endl;
+					break;
+				}
+				
+				if (m_idleTimeout) {
+					timeval timeout;
+					timeout.tv_sec = m_idleTimeout;
+					timeout.tv_usec = 0;
+					
+					::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+					::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+				}
+				
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_connections.insert(fd);
+				}
+				
+				pool.execute([this, fd] { serve(fd); });
+			}
+			
+			::close(listener);
+			::unlink(m_path.c_str());
+			
+			closeConnections();
+		} // waits for the pending requests
+		
+		return 0;
+	}
+	
+	void Server::serve(int fd)
+	{
+		thread_local std::unique_ptr<Session> session;
+		
+		if (!session)
+			session.reset(new Session(m_defaultBase));
+		
+		session->translator.deterministic(m_deterministic);
+		
+		std::unique_ptr<FdStreamBuf> buf(new FdStreamBuf(fd));
+		std::iostream stream(buf.get());
+		
+		try {
+			exchange(stream, stream, session->translator, m_maxRequest);
+		} catch (FrameException &e) {
+			std::cerr << "closing connection: " << e.what() << std::endl;
+		} catch (std::exception &e) {
+			Memory::Unlimited unlimited;
+			std::cerr << "closing connection: " << e.what() << std::endl;
+			
+			session.reset(); // the translator may be left in any state
+		}
+		
+		buf.reset();
+		
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_connections.erase(fd);
+		}
+		
+		::close(fd);
+	}
+	
+	void Server::closeConnections()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		// idle clients see the end of their connection, requests in progress are completed
+		for (int fd : m_connections)
+			::shutdown(fd, SHUT_RD);
+	}
+
+#endif /* _WIN32 */
+
+}
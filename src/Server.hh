@@ -0,0 +1,82 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_SERVER_HH
+#define CARL_SERVER_HH
+
+#include <cstddef>
+#include <string>
+#include <set>
+#include <mutex>
+#include <istream>
+#include <ostream>
+
+#include "Uri.hh"
+#include "Frame.hh"
+
+namespace n3 {
+	
+	class Translator;
+	
+	///
+	/// Translates documents sent over a Unix domain socket, see Frame.hh for the protocol.
+	/// Connections are handled on a thread pool, every pool thread reuses its own Translator.
+	/// An error on one connection, including running out of memory, only closes that connection.
+	///
+	class Server {
+		
+		std::string m_path;
+		Uri m_defaultBase;
+		unsigned m_threads;
+		bool m_deterministic;
+		std::size_t m_maxRequest;
+		unsigned m_idleTimeout;
+		
+		std::set<int> m_connections;
+		std::mutex m_mutex;
+		
+		void serve(int fd);
+		void closeConnections();
+		
+	public:
+		static const unsigned DEFAULT_IDLE_TIMEOUT = 60; // seconds
+		
+		Server(const std::string &path, const Uri &defaultBase, unsigned threads);
+		
+		/// Accepts connections until the process receives SIGINT or SIGTERM.
+		/// Returns the exit status for the process.
+		int run();
+		
+		/// See Translator::deterministic.
+		void deterministic(bool deterministic) { m_deterministic = deterministic; }
+		
+		/// Closes a connection that sends a request larger than maxRequest bytes.
+		void maxRequest(std::size_t maxRequest) { m_maxRequest = maxRequest; }
+		
+		/// Closes a connection that stays idle, or blocks writing a response, for more than
+		/// seconds, so idle clients do not hold on to the pool threads. 0 waits forever.
+		void idleTimeout(unsigned seconds) { m_idleTimeout = seconds; }
+		
+		/// Answers the requests read from in on out, flushing out after every response, until
+		/// in ends or writing fails. Throws FrameException when in is not a sequence of requests
+		/// or a request is larger than maxRequest bytes.
+		static void exchange(std::istream &in, std::ostream &out, Translator &translator, std::size_t maxRequest = frame::DEFAULT_MAX_REQUEST);
+	};
+
+}
+
+#endif /* CARL_SERVER_HH */
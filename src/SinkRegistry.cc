@@ -0,0 +1,110 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "SinkRegistry.hh"
+
+#include <map>
+
+#include "CN3Writer.hh"
+#include "ParallelN3PWriter.hh"
+#include "BinaryWriter.hh"
+#include "NTriplesWriter.hh"
+
+
+namespace n3 {
+	
+	namespace {
+		
+		TripleSink *n3p(std::ostream &out, const SinkOptions &options)
+		{
+			if (options.threads > 1) {
+				ParallelN3PWriter *writer = new ParallelN3PWriter(out, options.threads);
+				writer->normalizeNumbers(options.normalizeNumbers);
+				
+				return writer;
+			}
+			
+			CN3Writer *writer = new CN3Writer(out);
+			writer->normalizeNumbers(options.normalizeNumbers);
+			
+			return writer;
+		}
+		
+		TripleSink *ntriples(std::ostream &out, const SinkOptions &options)
+		{
+			NTriplesWriter *writer = new NTriplesWriter(out, false);
+			writer->normalizeNumbers(options.normalizeNumbers);
+			
+			return writer;
+		}
+		
+		TripleSink *nquads(std::ostream &out, const SinkOptions &options)
+		{
+			NTriplesWriter *writer = new NTriplesWriter(out, true);
+			writer->normalizeNumbers(options.normalizeNumbers);
+			
+			return writer;
+		}
+		
+		std::map<std::string, SinkRegistry::Factory> &registry()
+		{
+			static std::map<std::string, SinkRegistry::Factory> factories {
+				{ "n3p",      n3p },
+				{ "ntriples", ntriples },
+				{ "nquads",   nquads },
+				{ "binary",   [](std::ostream &out, const SinkOptions &) { return new BinaryWriter(out); } },
+				{ "null",     [](std::ostream &, const SinkOptions &)    { return new DefaultTripleSink(); } }
+			};
+			
+			return factories;
+		}
+	}
+	
+	const std::string SinkRegistry::DEFAULT_FORMAT("n3p");
+	
+	void SinkRegistry::add(const std::string &format, const Factory &factory)
+	{
+		registry()[format] = factory;
+	}
+	
+	bool SinkRegistry::contains(const std::string &format)
+	{
+		return registry().count(format) != 0;
+	}
+	
+	std::unique_ptr<TripleSink> SinkRegistry::create(const std::string &format, std::ostream &out, const SinkOptions &options)
+	{
+		auto i = registry().find(format);
+		if (i == registry().end())
+			return std::unique_ptr<TripleSink>();
+		
+		return std::unique_ptr<TripleSink>(i->second(out, options));
+	}
+	
+	std::string SinkRegistry::formats()
+	{
+		std::string names;
+		for (const auto &entry : registry()) {
+			if (!names.empty())
+				names += '|';
+			names += entry.first;
+		}
+		
+		return names;
+	}
+
+}
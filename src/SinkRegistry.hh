@@ -0,0 +1,60 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_SINK_REGISTRY_HH
+#define CARL_SINK_REGISTRY_HH
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "Parser.hh"
+
+namespace n3 {
+	
+	/// Options for the sinks, a sink ignores the options it does not support.
+	struct SinkOptions {
+		bool normalizeNumbers;
+		unsigned threads; // the threads formatting the output, 0 or 1 formats on the calling thread
+	};
+	
+	///
+	/// The output formats, every format has a name and a factory creating its TripleSink.
+	///
+	class SinkRegistry {
+	public:
+		
+		typedef std::function<TripleSink *(std::ostream &out, const SinkOptions &options)> Factory;
+		
+		static const std::string DEFAULT_FORMAT;
+		
+		/// Adds (or replaces) a format.
+		static void add(const std::string &format, const Factory &factory);
+		
+		static bool contains(const std::string &format);
+		
+		/// Creates a sink writing to out, returns a null pointer for an unknown format.
+		static std::unique_ptr<TripleSink> create(const std::string &format, std::ostream &out, const SinkOptions &options);
+		
+		/// The names of all formats, separated by '|'.
+		static std::string formats();
+	};
+
+}
+
+#endif /* CARL_SINK_REGISTRY_HH */
@@ -0,0 +1,132 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_SPSC_RING_HH
+#define CARL_SPSC_RING_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace n3 {
+	
+	///
+	/// A lock-free ring of N reusable slots between one producer and one consumer thread.
+	///
+	/// The producer fills the slot returned by acquire() and hands it over with publish(),
+	/// the consumer reads the slot returned by peek() and gives it back with release().
+	/// A waiting thread yields a bounded number of times, then sleeps until the other side
+	/// moves on, so an idle stage does not burn a core. After cancel(), acquire() and peek()
+	/// return nullptr.
+	///
+	template<typename T, std::size_t N>
+	class SpscRing {
+		
+		T m_slots[N];
+		
+		std::atomic<std::size_t> m_head; // the next slot to read, only written by the consumer
+		std::atomic<std::size_t> m_tail; // the next slot to write, only written by the producer
+		std::atomic<bool> m_cancelled;
+		
+		// m_head, m_tail and m_sleepers use sequentially consistent accesses: a thread going to
+		// sleep and a thread moving an index must see at least one of each other's writes.
+		std::atomic<unsigned> m_sleepers; // threads blocked in wait(), so publish() and release() know to notify
+		std::mutex m_mutex;
+		std::condition_variable m_wakeUp;
+		
+		static constexpr unsigned SPINS = 64;
+		
+		/// Waits until ready() holds, returns false if the ring is cancelled first.
+		template<typename Ready>
+		bool wait(Ready ready)
+		{
+			for (unsigned i = 0; i < SPINS; i++) {
+				if (ready())
+					return true;
+				if (m_cancelled.load(std::memory_order_relaxed))
+					return false;
+				std::this_thread::yield();
+			}
+			
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_sleepers.fetch_add(1);
+			m_wakeUp.wait(lock, [&] { return ready() || m_cancelled.load(); });
+			m_sleepers.fetch_sub(1);
+			
+			return ready();
+		}
+		
+		void notify()
+		{
+			if (m_sleepers.load()) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_wakeUp.notify_all();
+			}
+		}
+		
+	public:
+		SpscRing() : m_slots(), m_head(0), m_tail(0), m_cancelled(false), m_sleepers(0), m_mutex(), m_wakeUp() {}
+		
+		SpscRing(const SpscRing &) = delete;
+		SpscRing &operator=(const SpscRing &) = delete;
+		
+		T *acquire()
+		{
+			std::size_t tail = m_tail.load(std::memory_order_relaxed);
+			
+			if (!wait([&] { return tail - m_head.load() != N; }))
+				return nullptr;
+			
+			return m_cancelled.load(std::memory_order_relaxed) ? nullptr : &m_slots[tail % N];
+		}
+		
+		void publish()
+		{
+			m_tail.store(m_tail.load(std::memory_order_relaxed) + 1);
+			notify();
+		}
+		
+		T *peek()
+		{
+			std::size_t head = m_head.load(std::memory_order_relaxed);
+			
+			if (!wait([&] { return head != m_tail.load(); }))
+				return nullptr;
+			
+			return &m_slots[head % N];
+		}
+		
+		void release()
+		{
+			m_head.store(m_head.load(std::memory_order_relaxed) + 1);
+			notify();
+		}
+		
+		void cancel()
+		{
+			m_cancelled.store(true);
+			
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_wakeUp.notify_all();
+		}
+	};
+
+}
+
+#endif /* CARL_SPSC_RING_HH */
@@ -0,0 +1,316 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Streams.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#	include <io.h>
+#	define CARL_READ  ::_read
+#	define CARL_WRITE ::_write
+#else
+#	include <unistd.h>
+#	include <fcntl.h> // posix_fadvise
+#	include <poll.h>
+#	include <sys/stat.h>
+#	define CARL_READ  ::read
+#	define CARL_WRITE ::write
+#endif
+
+namespace n3 {
+	
+	FdStreamBuf::int_type FdStreamBuf::underflow()
+	{
+		if (gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		
+		for (;;) {
+			auto n = CARL_READ(m_fd, m_in, BUFFER_SIZE);
+			if (n > 0) {
+				setg(m_in, m_in, m_in + n);
+				
+				return traits_type::to_int_type(*gptr());
+			}
+			
+			if (n < 0 && errno == EINTR)
+				continue;
+			
+			return traits_type::eof();
+		}
+	}
+	
+	FdStreamBuf::int_type FdStreamBuf::overflow(int_type c)
+	{
+		if (!flushOutput())
+			return traits_type::eof();
+		
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		
+		return traits_type::not_eof(c);
+	}
+	
+	int FdStreamBuf::sync()
+	{
+		return flushOutput() ? 0 : -1;
+	}
+	
+	bool FdStreamBuf::flushOutput()
+	{
+		const char *p = pbase();
+		
+		while (p < pptr()) {
+			auto n = CARL_WRITE(m_fd, p, pptr() - p);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				
+				setp(m_out, m_out + BUFFER_SIZE);
+				
+				return false;
+			}
+			
+			p += n;
+		}
+		
+		setp(m_out, m_out + BUFFER_SIZE);
+		
+		return true;
+	}
+
+	
+	FdSource::FdSource(int fd, const std::string &prefix) : ByteSource(), m_fd(fd), m_prefix(prefix), m_position(0), m_wake{-1, -1}
+	{
+#ifdef POSIX_FADV_SEQUENTIAL
+		::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#ifndef _WIN32
+		struct stat status;
+		if (::fstat(m_fd, &status) == 0 && !S_ISREG(status.st_mode) && ::pipe(m_wake) != 0)
+			throw std::runtime_error(std::string("error creating pipe: ") + std::strerror(errno));
+#endif
+	}
+	
+	FdSource::~FdSource()
+	{
+#ifndef _WIN32
+		if (m_wake[0] != -1) {
+			::close(m_wake[0]);
+			::close(m_wake[1]);
+		}
+#endif
+	}
+	
+	void FdSource::interrupt()
+	{
+#ifndef _WIN32
+		if (m_wake[1] != -1) {
+			char c = 0;
+			while (CARL_WRITE(m_wake[1], &c, 1) < 0 && errno == EINTR)
+				;
+		}
+#endif
+	}
+	
+	std::size_t FdSource::read(char *data, std::size_t size)
+	{
+		if (m_position < m_prefix.size()) {
+			std::size_t n = m_prefix.copy(data, size, m_position);
+			m_position += n;
+			
+			return n;
+		}
+		
+#ifndef _WIN32
+		if (m_wake[0] != -1) {
+			struct pollfd fds[2] = { { m_fd, POLLIN, 0 }, { m_wake[0], POLLIN, 0 } };
+			
+			while (::poll(fds, 2, -1) < 0) {
+				if (errno != EINTR)
+					throw InputException(std::string("error reading input: ") + std::strerror(errno));
+			}
+			
+			if (fds[1].revents != 0)
+				return 0; // interrupted
+		}
+#endif
+		
+		for (;;) {
+			auto n = CARL_READ(m_fd, data, size);
+			if (n >= 0)
+				return n;
+			
+			if (errno != EINTR)
+				throw InputException(std::string("error reading input: ") + std::strerror(errno));
+		}
+	}
+	
+	std::size_t FdSource::readFully(int fd, char *data, std::size_t size)
+	{
+		std::size_t n = 0;
+		
+		while (n < size) {
+			auto k = CARL_READ(fd, data + n, size - n);
+			if (k == 0)
+				break;
+			
+			if (k < 0) {
+				if (errno == EINTR)
+					continue;
+				
+				throw InputException(std::string("error reading input: ") + std::strerror(errno));
+			}
+			
+			n += k;
+		}
+		
+		return n;
+	}
+	
+	ReadAheadStreamBuf::ReadAheadStreamBuf(std::unique_ptr<ByteSource> source, std::size_t size, std::size_t depth)
+		: std::streambuf(), m_source(std::move(source)), m_size((size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT), m_memory(), m_chunks(depth ? depth : 1),
+		  m_mutex(), m_filled(), m_released(), m_read(0), m_consumed(0), m_current(false), m_eof(false), m_stopping(false), m_error(), m_reader()
+	{
+		if (m_size == 0)
+			m_size = ALIGNMENT;
+		
+		m_memory.reset(new char[m_chunks.size() * m_size + ALIGNMENT]);
+		
+		std::uintptr_t address = reinterpret_cast<std::uintptr_t>(m_memory.get());
+		char *data = m_memory.get() + (ALIGNMENT - address % ALIGNMENT) % ALIGNMENT;
+		
+		for (Chunk &chunk : m_chunks) {
+			chunk.data = data;
+			chunk.size = 0;
+			data += m_size;
+		}
+		
+		setg(nullptr, nullptr, nullptr);
+		
+		m_reader = std::thread(&ReadAheadStreamBuf::read, this);
+	}
+	
+	ReadAheadStreamBuf::ReadAheadStreamBuf(int fd, std::size_t size, std::size_t depth)
+		: ReadAheadStreamBuf(std::unique_ptr<ByteSource>(new FdSource(fd)), size, depth)
+	{
+		// nop
+	}
+	
+	ReadAheadStreamBuf::~ReadAheadStreamBuf()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		
+		m_released.notify_one();
+		m_source->interrupt(); // the reader may wait for input that never comes, like after a parse error
+		m_reader.join();
+	}
+	
+	std::string ReadAheadStreamBuf::error()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		return m_error;
+	}
+	
+	std::size_t ReadAheadStreamBuf::fill(char *data, bool &eof)
+	{
+		// one read: on a pipe it returns what has arrived, which is passed on without waiting for more
+		std::size_t size = m_source->read(data, m_size);
+		if (size == 0)
+			eof = true;
+		
+		return size;
+	}
+	
+	void ReadAheadStreamBuf::read()
+	{
+		for (;;) {
+			Chunk *chunk;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_released.wait(lock, [this] { return m_stopping || m_read - m_consumed < m_chunks.size(); });
+				
+				if (m_stopping)
+					return;
+				
+				chunk = &m_chunks[m_read % m_chunks.size()];
+			}
+			
+			std::string error;
+			bool eof = false;
+			try {
+				chunk->size = fill(chunk->data, eof); // the chunk is not visible to underflow() until published
+			} catch (std::exception &e) {
+				chunk->size = 0;
+				error = e.what();
+				eof = true;
+			}
+			
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				
+				if (chunk->size > 0)
+					++m_read;
+				
+				if (eof) {
+					m_eof = true;
+					m_error = error;
+				}
+			}
+			
+			m_filled.notify_one();
+			
+			if (m_eof)
+				return;
+		}
+	}
+	ReadAheadStreamBuf::int_type ReadAheadStreamBuf::underflow()
+	{
+		if (gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		
+		std::unique_lock<std::mutex> lock(m_mutex);
+		
+		if (m_current) {
+			m_current = false;
+			++m_consumed;
+			m_released.notify_one();
+		}
+		
+		m_filled.wait(lock, [this] { return m_eof || m_read > m_consumed; });
+		
+		if (m_read == m_consumed)
+			return traits_type::eof();
+		
+		const Chunk &chunk = m_chunks[m_consumed % m_chunks.size()];
+		m_current = true;
+		
+		setg(chunk.data, chunk.data, chunk.data + chunk.size);
+		
+		return traits_type::to_int_type(*gptr());
+	}
+
+}
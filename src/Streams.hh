@@ -0,0 +1,232 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_STREAMS_HH
+#define CARL_STREAMS_HH
+
+#include <cstddef>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace n3 {
+	
+	/// Thrown when the input can not be read: a read error, or a damaged archive or compressed stream.
+	class InputException : public std::runtime_error {
+	public:
+		explicit InputException(const std::string &message = std::string()) : std::runtime_error(message) {}
+	};
+	
+	///
+	/// Read-only stream buffer over a block of memory, the memory is not copied.
+	///
+	class MemoryStreamBuf : public std::streambuf {
+	public:
+		MemoryStreamBuf() : std::streambuf() {}
+		
+		MemoryStreamBuf(const char *data, std::size_t size) : std::streambuf()
+		{
+			reset(data, size);
+		}
+		
+		void reset(const char *data, std::size_t size)
+		{
+			char *p = const_cast<char *>(data);
+			setg(p, p, p + size);
+		}
+	};
+	
+	///
+	/// Output stream buffer appending to a std::string, gives access to the
+	/// written data without the copy std::ostringstream::str() makes.
+	///
+	class StringStreamBuf : public std::streambuf {
+		
+		std::string m_value;
+		
+	protected:
+		int_type overflow(int_type c) override
+		{
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+				m_value.push_back(traits_type::to_char_type(c));
+			
+			return traits_type::not_eof(c);
+		}
+		
+		std::streamsize xsputn(const char_type *s, std::streamsize n) override
+		{
+			m_value.append(s, n);
+			
+			return n;
+		}
+		
+	public:
+		StringStreamBuf() : std::streambuf(), m_value() {}
+		
+		const std::string &str() const { return m_value; }
+		
+		void clear() { m_value.clear(); }
+	};
+	
+	///
+	/// Buffered stream buffer reading from and writing to a file descriptor.
+	/// The descriptor is not closed by the buffer.
+	///
+	class FdStreamBuf : public std::streambuf {
+		
+		static const std::size_t BUFFER_SIZE = 64 * 1024;
+		
+		int m_fd;
+		char m_in[BUFFER_SIZE];
+		char m_out[BUFFER_SIZE];
+		
+		bool flushOutput();
+		
+	protected:
+		int_type underflow() override;
+		int_type overflow(int_type c) override;
+		int sync() override;
+		
+	public:
+		explicit FdStreamBuf(int fd) : std::streambuf(), m_fd(fd)
+		{
+			setg(m_in, m_in, m_in);
+			setp(m_out, m_out + BUFFER_SIZE);
+		}
+		
+		FdStreamBuf(const FdStreamBuf &) = delete;
+		FdStreamBuf &operator=(const FdStreamBuf &) = delete;
+		
+		~FdStreamBuf()
+		{
+			sync();
+		}
+		
+		int fd() const { return m_fd; }
+	};
+
+	
+	///
+	/// A source of bytes for ReadAheadStreamBuf, read on its thread.
+	///
+	struct ByteSource {
+		/// Reads at most size bytes, returns 0 at the end of the input. Throws
+		/// InputException when the input can not be read.
+		virtual std::size_t read(char *data, std::size_t size) = 0;
+		
+		/// Makes a read() waiting for input, and every later one, return 0. Called from another thread.
+		virtual void interrupt() {}
+		
+		virtual ~ByteSource() {}
+	};
+	
+	///
+	/// Source reading a file descriptor, after returning the bytes of prefix
+	/// (bytes already read from the descriptor). The descriptor is not closed.
+	///
+	/// A pipe, terminal or socket is polled together with a pipe of its own, so
+	/// interrupt() ends a read() waiting for input (not on Windows). A regular
+	/// file never keeps a read waiting, it is read directly.
+	///
+	class FdSource : public ByteSource {
+		
+		int m_fd;
+		std::string m_prefix;
+		std::size_t m_position;
+		int m_wake[2]; // the pipe written by interrupt(), -1 for a regular file
+		
+	public:
+		explicit FdSource(int fd, const std::string &prefix = std::string());
+		
+		FdSource(const FdSource &) = delete;
+		FdSource &operator=(const FdSource &) = delete;
+		
+		~FdSource();
+		
+		std::size_t read(char *data, std::size_t size) override;
+		void interrupt() override;
+		
+		/// Reads until size bytes are read or the input ends.
+		static std::size_t readFully(int fd, char *data, std::size_t size);
+	};
+	
+	///
+	/// Input stream buffer reading a source ahead on a thread of its own.
+	/// The thread fills up to depth chunks of size bytes while the chunks read
+	/// before are consumed, so waiting for the disk (or decompressing) overlaps
+	/// with parsing. A chunk is passed on after one read of the source, so input
+	/// from a pipe is parsed as it arrives. A read error ends the input, see error().
+	///
+	class ReadAheadStreamBuf : public std::streambuf {
+		
+		static const std::size_t ALIGNMENT = 4096;
+		
+		struct Chunk {
+			char *data;
+			std::size_t size;
+		};
+		
+		std::unique_ptr<ByteSource> m_source;
+		std::size_t m_size;
+		std::unique_ptr<char[]> m_memory;
+		std::vector<Chunk> m_chunks;
+		
+		std::mutex m_mutex;
+		std::condition_variable m_filled;
+		std::condition_variable m_released;
+		std::size_t m_read;     // the number of chunks filled by the reader
+		std::size_t m_consumed; // the number of chunks released by underflow()
+		bool m_current;         // the get area is a chunk not released yet
+		bool m_eof;
+		bool m_stopping;
+		std::string m_error;
+		
+		std::thread m_reader;
+		
+		void read();
+		std::size_t fill(char *data, bool &eof);
+		
+	protected:
+		int_type underflow() override;
+		
+	public:
+		static const std::size_t DEFAULT_SIZE  = 1024 * 1024;
+		static const std::size_t DEFAULT_DEPTH = 3;
+		
+		/// A size that is not a multiple of 4096 is rounded up.
+		ReadAheadStreamBuf(std::unique_ptr<ByteSource> source, std::size_t size = DEFAULT_SIZE, std::size_t depth = DEFAULT_DEPTH);
+		
+		/// Reads a file descriptor, which is not closed by the buffer.
+		ReadAheadStreamBuf(int fd, std::size_t size = DEFAULT_SIZE, std::size_t depth = DEFAULT_DEPTH);
+		
+		ReadAheadStreamBuf(const ReadAheadStreamBuf &) = delete;
+		ReadAheadStreamBuf &operator=(const ReadAheadStreamBuf &) = delete;
+		
+		~ReadAheadStreamBuf();
+		
+		/// The message of the error that ended the input, empty if the input was read completely (so far).
+		std::string error();
+	};
+
+}
+
+#endif /* CARL_STREAMS_HH */
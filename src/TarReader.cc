@@ -0,0 +1,227 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "TarReader.hh"
+#include "Streams.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace n3 {
+	
+	namespace {
+		
+		// the fields of a header block used
+		const std::size_t NAME      = 0;
+		const std::size_t NAME_SIZE = 100;
+		const std::size_t SIZE      = 124;
+		const std::size_t SIZE_SIZE = 12;
+		const std::size_t CHECKSUM  = 148;
+		const std::size_t CHECKSUM_SIZE = 8;
+		const std::size_t TYPE      = 156;
+		const std::size_t MAGIC     = 257;
+		const std::size_t PREFIX    = 345;
+		const std::size_t PREFIX_SIZE = 155;
+		
+		std::string field(const char *block, std::size_t offset, std::size_t size)
+		{
+			const char *p = block + offset;
+			
+			return std::string(p, ::strnlen(p, size));
+		}
+		
+		std::uint64_t padded(std::uint64_t size)
+		{
+			return (size + TarReader::BLOCK_SIZE - 1) / TarReader::BLOCK_SIZE * TarReader::BLOCK_SIZE;
+		}
+	}
+	
+	std::uint64_t TarReader::number(const char *field, std::size_t length)
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(field);
+		std::uint64_t value = 0;
+		
+		if (p[0] & 0x80) { // base-256, for sizes of 8 GB and more
+			value = p[0] & 0x3F;
+			for (std::size_t i = 1; i < length; i++)
+				value = (value << 8) | p[i];
+			
+			return value;
+		}
+		
+		std::size_t i = 0;
+		while (i < length && p[i] == ' ')
+			i++;
+		
+		for (; i < length && p[i] >= '0' && p[i] <= '7'; i++)
+			value = (value << 3) | (p[i] - '0');
+		
+		return value;
+	}
+	
+	std::string TarReader::pathRecord(const std::string &records)
+	{
+		// records are "length key=value\n"
+		std::string path;
+		std::size_t i = 0;
+		
+		while (i < records.size()) {
+			std::size_t space = records.find(' ', i);
+			if (space == std::string::npos)
+				break;
+			
+			std::size_t length = std::strtoul(records.c_str() + i, nullptr, 10);
+			if (length == 0 || i + length > records.size())
+				break;
+			
+			std::size_t end = i + length - 1; // the newline
+			if (records.compare(space + 1, 5, "path=") == 0 && space + 6 <= end)
+				path = records.substr(space + 6, end - space - 6);
+			
+			i += length;
+		}
+		
+		return path;
+	}
+	
+	void TarReader::skip(std::uint64_t size)
+	{
+		char buffer[BLOCK_SIZE * 8];
+		
+		while (size > 0) {
+			std::size_t n = size < sizeof(buffer) ? static_cast<std::size_t>(size) : sizeof(buffer);
+			if (!m_in.read(buffer, n))
+				throw InputException("truncated tar archive");
+			
+			size -= n;
+		}
+	}
+	
+	std::string TarReader::read(std::uint64_t size)
+	{
+		std::string data(static_cast<std::size_t>(size), '\0');
+		
+		if (size > 0 && !m_in.read(&data[0], data.size()))
+			throw InputException("truncated tar archive");
+		
+		skip(padded(size) - size);
+		
+		return data;
+	}
+	
+	bool TarReader::next()
+	{
+		skip(m_unread);
+		m_unread = 0;
+		
+		std::string longName;
+		
+		for (;;) {
+			char block[BLOCK_SIZE];
+			
+			if (!m_in.read(block, BLOCK_SIZE)) {
+				if (m_in.gcount() == 0)
+					return false; // some writers leave out the end blocks
+				
+				throw InputException("truncated tar archive");
+			}
+			
+			bool empty = true;
+			for (char c : block) {
+				if (c) {
+					empty = false;
+					break;
+				}
+			}
+			
+			if (empty)
+				return false;
+			
+			unsigned sum = 0;
+			for (std::size_t i = 0; i < BLOCK_SIZE; i++)
+				sum += (i >= CHECKSUM && i < CHECKSUM + CHECKSUM_SIZE) ? ' ' : static_cast<unsigned char>(block[i]);
+			
+			if (sum != number(block + CHECKSUM, CHECKSUM_SIZE))
+				throw InputException("damaged tar archive, header checksum mismatch");
+			
+			std::uint64_t size = number(block + SIZE, SIZE_SIZE);
+			char type = block[TYPE];
+			
+			switch (type) {
+				case 'L': { // GNU long name of the next member
+					longName = read(size);
+					longName.resize(::strnlen(longName.c_str(), longName.size()));
+					break;
+				}
+				case 'x': { // pax extended header of the next member
+					std::string path = pathRecord(read(size));
+					if (!path.empty())
+						longName = path;
+					break;
+				}
+				case '0':
+				case '\0':
+				case '7': {
+					if (!longName.empty()) {
+						m_name = longName;
+					} else {
+						m_name = field(block, NAME, NAME_SIZE);
+						if (std::memcmp(block + MAGIC, "ustar", 5) == 0 && block[PREFIX])
+							m_name = field(block, PREFIX, PREFIX_SIZE) + "/" + m_name;
+					}
+					
+					m_size   = size;
+					m_unread = padded(size);
+					
+					return true;
+				}
+				default:
+					// directories, links, global pax headers...: their contents (if any) are skipped
+					skip(padded(size));
+					if (type != 'K' && type != 'g') // a long link name or global header keeps the long name
+						longName.clear();
+					break;
+			}
+		}
+	}
+	
+	std::string TarReader::contents()
+	{
+		if (m_unread != padded(m_size))
+			throw std::logic_error("the contents of a tar member can only be read once");
+		
+		m_unread = 0;
+		
+		return read(m_size);
+	}
+	
+	bool TarReader::isArchive(const std::string &path)
+	{
+		static const char *const EXTENSIONS[] = { ".tar", ".tgz", ".tar.gz", ".tar.bz2", ".tbz2", ".tar.zst" };
+		
+		for (const char *extension : EXTENSIONS) {
+			std::size_t n = std::strlen(extension);
+			if (path.size() > n && path.compare(path.size() - n, n, extension) == 0)
+				return true;
+		}
+		
+		return false;
+	}
+
+}
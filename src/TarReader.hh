@@ -0,0 +1,69 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_TAR_READER_HH
+#define CARL_TAR_READER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+namespace n3 {
+	
+	///
+	/// Reads the regular files of a tar archive (ustar, with GNU long names
+	/// and pax paths) from a stream, in one pass. Other members, like
+	/// directories and links, are skipped.
+	///
+	class TarReader {
+		
+		std::istream &m_in;
+		std::string m_name;
+		std::uint64_t m_size;
+		std::uint64_t m_unread; // the bytes of the current member not read yet, padding included
+		
+		void skip(std::uint64_t size);
+		std::string read(std::uint64_t size);
+		
+		static std::uint64_t number(const char *field, std::size_t length);
+		static std::string pathRecord(const std::string &records);
+		
+	public:
+		static const std::size_t BLOCK_SIZE = 512;
+		
+		explicit TarReader(std::istream &in) : m_in(in), m_name(), m_size(0), m_unread(0) {}
+		
+		/// Advances to the next regular file, returns false at the end of the archive.
+		/// Throws InputException for a damaged archive.
+		bool next();
+		
+		/// The path of the current member in the archive.
+		const std::string &name() const { return m_name; }
+		
+		std::uint64_t size() const { return m_size; }
+		
+		/// Reads the contents of the current member, at most once per member.
+		std::string contents();
+		
+		/// True for the names of tar files: .tar, .tgz, .tar.gz, .tar.bz2, .tbz2 and .tar.zst.
+		static bool isArchive(const std::string &path);
+	};
+
+}
+
+#endif /* CARL_TAR_READER_HH */
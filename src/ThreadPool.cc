@@ -0,0 +1,93 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "ThreadPool.hh"
+
+#include <utility>
+#include <exception>
+#include <iostream>
+
+namespace n3 {
+	
+	ThreadPool::ThreadPool(unsigned threads) : m_workers(), m_tasks(), m_mutex(), m_available(), m_stopping(false)
+	{
+		if (threads == 0)
+			threads = 1;
+		
+		m_workers.reserve(threads);
+		for (unsigned i = 0; i < threads; i++)
+			m_workers.push_back(std::thread(&ThreadPool::work, this));
+	}
+	
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		
+		m_available.notify_all();
+		
+		for (std::thread &worker : m_workers)
+			worker.join();
+	}
+	
+	void ThreadPool::execute(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push_back(std::move(task));
+		}
+		
+		m_available.notify_one();
+	}
+	
+	void ThreadPool::work()
+	{
+		for (;;) {
+			std::function<void()> task;
+			
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_available.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+				
+				if (m_tasks.empty())
+					return; // stopping and nothing left to do
+				
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			
+			try {
+				task();
+			} catch (std::exception &e) {
+				// tasks report their own errors, this only keeps the worker and the process alive
+				std::cerr << "error in worker thread: " << e.what() << std::endl;
+			} catch (...) {
+				std::cerr << "error in worker thread" << std::endl;
+			}
+		}
+	}
+	
+	unsigned ThreadPool::defaultSize()
+	{
+		unsigned n = std::thread::hardware_concurrency();
+		
+		return n ? n : 1;
+	}
+
+}
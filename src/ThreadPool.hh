@@ -0,0 +1,64 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_THREAD_POOL_HH
+#define CARL_THREAD_POOL_HH
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace n3 {
+	
+	///
+	/// Fixed size pool of worker threads executing tasks in submission order.
+	/// The destructor waits until all submitted tasks have completed.
+	/// An exception escaping a task is reported on stderr and does not stop the worker.
+	///
+	class ThreadPool {
+		
+		std::vector<std::thread> m_workers;
+		std::deque<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_available;
+		bool m_stopping;
+		
+		void work();
+		
+	public:
+		
+		explicit ThreadPool(unsigned threads = defaultSize());
+		
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+		
+		~ThreadPool();
+		
+		void execute(std::function<void()> task);
+		
+		std::size_t size() const { return m_workers.size(); }
+		
+		static unsigned defaultSize();
+	};
+
+}
+
+#endif /* CARL_THREAD_POOL_HH */
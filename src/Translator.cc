@@ -0,0 +1,55 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Translator.hh"
+
+namespace n3 {
+	
+	Translator::Translator(const Uri &defaultBase)
+		: m_defaultBase(defaultBase),
+		  m_inbuf(), m_in(&m_inbuf), m_outbuf(), m_out(&m_outbuf),
+		  m_writer(m_out), m_parser(&m_in, defaultBase, &m_writer), m_deterministic(false)
+	{
+	}
+	
+	const std::string &Translator::translate(const std::string &base, const char *data, std::size_t size)
+	{
+		m_outbuf.clear();
+		m_inbuf.reset(data, size);
+		m_in.clear();
+		
+		try {
+			m_parser.reset(&m_in, base.empty() ? m_defaultBase : Uri(base));
+		} catch (UriSyntaxException &e) {
+			throw ParseException(e.what());
+		}
+		
+		if (m_deterministic) {
+			Hash64 hash;
+			hash.update(data, size);
+			m_parser.deterministic(hash.value());
+		}
+		
+		m_writer.reset();
+		m_writer.start();
+		m_parser.parse();
+		m_writer.end();
+		
+		return m_outbuf.str();
+	}
+
+}
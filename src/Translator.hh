@@ -0,0 +1,71 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef CARL_TRANSLATOR_HH
+#define CARL_TRANSLATOR_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include "Uri.hh"
+#include "Parser.hh"
+#include "CN3Writer.hh"
+#include "Streams.hh"
+
+namespace n3 {
+	
+	///
+	/// Translates in-memory N3 documents to N3P, one after the other.
+	/// The parser and writer are created once and reused for every document.
+	///
+	class Translator {
+		
+		Uri m_defaultBase;
+		
+		MemoryStreamBuf m_inbuf;
+		std::istream m_in;
+		StringStreamBuf m_outbuf;
+		std::ostream m_out;
+		
+		CN3Writer m_writer;
+		Parser m_parser;
+		
+		bool m_deterministic;
+		
+	public:
+		explicit Translator(const Uri &defaultBase);
+		
+		Translator(const Translator &) = delete;
+		Translator &operator=(const Translator &) = delete;
+		
+		/// Returns the complete N3P document, valid until the next call.
+		/// When base is empty, the default base is used.
+		/// Throws ParseException when the document is not valid N3.
+		const std::string &translate(const std::string &base, const char *data, std::size_t size);
+		
+		std::uint64_t count() const { return m_writer.count(); }
+		
+		/// Derives the blank node ids of every document from its contents, see Parser::deterministic.
+		void deterministic(bool deterministic) { m_deterministic = deterministic; }
+	};
+
+}
+
+#endif /* CARL_TRANSLATOR_HH */
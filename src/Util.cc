@@ -16,16 +16,20 @@
 
 
 #include <string>
+#include <cstdint>
 #include <climits>
 #include <cstdlib>
 #include <stdexcept>
 #include <algorithm>
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #ifdef _WIN32
 #	include <io.h>     // _setmode
 #	include <fcntl.h>  // _O_BINARY
+#	include <direct.h> // _mkdir
 #endif
 
 
@@ -72,4 +76,48 @@ namespace n3 {
 		return access(fileName.c_str(), F_OK) == 0;
 	}
 	
+	bool createDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		return ::_mkdir(path.c_str()) == 0;
+#else
+		return ::mkdir(path.c_str(), 0777) == 0;
+#endif
+	}
+	
+	int openFile(const std::string &path)
+	{
+#ifdef _WIN32
+		return ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+		return ::open(path.c_str(), O_RDONLY);
+#endif
+	}
+	
+	void closeFile(int fd)
+	{
+#ifdef _WIN32
+		::_close(fd);
+#else
+		::close(fd);
+#endif
+	}
+	
+	bool fileStatus(const std::string &path, std::uint64_t &size, std::int64_t &mtime)
+	{
+		struct stat st;
+		if (::stat(path.c_str(), &st) != 0)
+			return false;
+		
+		size  = st.st_size;
+		mtime = static_cast<std::int64_t>(st.st_mtime) * 1000000000;
+#if defined(__linux__)
+		mtime += st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+		mtime += st.st_mtimespec.tv_nsec;
+#endif
+		
+		return true;
+	}
+	
 }
@@ -17,15 +17,29 @@
 #ifndef CARL_UTIL_HH
 #define CARL_UTIL_HH
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace n3 {
+	
+	const std::size_t OUTPUT_BUFFER_SIZE = 1024 * 1024;
 
 	void useBinaryStreams();
 	
 	std::string toUri(const std::string &file);
 	
 	bool exists(const std::string &fileName);
+	
+	bool createDirectory(const std::string &path);
+	
+	/// Opens a file for reading, returns its descriptor or -1.
+	int openFile(const std::string &path);
+	
+	void closeFile(int fd);
+	
+	/// Retrieves the size and modification time (in nanoseconds since the epoch) of a file.
+	bool fileStatus(const std::string &path, std::uint64_t &size, std::int64_t &mtime);
 }
 
 #endif /* CARL_UTIL_HH */
@@ -0,0 +1,97 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+
+#include "../src/Batch.hh"
+#include "../src/Manifest.hh"
+#include "../src/Util.hh"
+
+namespace {
+	
+	/// Sets the modification time of path to seconds since the epoch.
+	void touch(const std::string &path, std::int64_t seconds)
+	{
+		struct timespec times[2] = { { 0, UTIME_OMIT }, { static_cast<time_t>(seconds), 0 } };
+		REQUIRE(::utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+	}
+	
+	std::int64_t mtime(const std::string &path)
+	{
+		std::uint64_t size;
+		std::int64_t mtime;
+		REQUIRE(n3::fileStatus(path, size, mtime));
+		
+		return mtime;
+	}
+	
+}
+
+TEST_CASE("touching an input without changing it records its new mtime", "[batch]")
+{
+	char dir[] = "/tmp/carl-test-XXXXXX";
+	REQUIRE(::mkdtemp(dir) != nullptr);
+	
+	const std::string input  = std::string(dir) + "/a.n3";
+	const std::string output = std::string(dir) + "/a.n3p";
+	const std::string manifest = std::string(dir) + "/" + n3::Manifest::FILE_NAME;
+	
+	std::ofstream(input) << "<http://example.org/s> <http://example.org/p> <http://example.org/o> .\n";
+	touch(input, 1000000000);
+	
+	const std::vector<std::string> inputs { input };
+	std::uint64_t count;
+	
+	{
+		n3::Batch batch(dir, n3::Optional<std::string>(), 1, true);
+		REQUIRE(batch.run(inputs, count) == 0);
+	}
+	
+	touch(input, 1000000100);
+	touch(output, 1000000000); // a new translation would change it
+	
+	{
+		n3::Batch batch(dir, n3::Optional<std::string>(), 1, true);
+		REQUIRE(batch.run(inputs, count) == 0);
+	}
+	
+	CHECK(count == 1);
+	CHECK(mtime(output) == std::int64_t(1000000000) * 1000000000);
+	
+	n3::Manifest m;
+	REQUIRE(m.load(manifest));
+	const n3::Manifest::Entry *e = m.find(n3::toUri(input));
+	REQUIRE(e != nullptr);
+	CHECK(e->mtime == mtime(input));
+	
+	std::remove(manifest.c_str());
+	std::remove(output.c_str());
+	std::remove(input.c_str());
+	::rmdir(dir);
+}
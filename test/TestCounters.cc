@@ -0,0 +1,128 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cstdint>
+#include <istream>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+#include "catch.hpp"
+
+#include "../src/Parser.hh"
+#include "../src/CN3Writer.hh"
+#include "../src/BlankNodeIdGenerator.hh"
+
+namespace {
+	
+	const std::uint64_t TWO_TO_32 = std::uint64_t(1) << 32;
+	
+	/// Generates a document of count triples without holding it in memory,
+	/// so very large inputs can be fed to the parser.
+	class SyntheticStreamBuf : public std::streambuf {
+		
+		std::uint64_t m_count;
+		std::uint64_t m_next;
+		std::string m_line;
+		
+	public:
+		
+		explicit SyntheticStreamBuf(std::uint64_t count) : std::streambuf(), m_count(count), m_next(0), m_line() {}
+		
+	protected:
+		
+		int_type underflow() override
+		{
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+			
+			if (m_next == m_count)
+				return traits_type::eof();
+			
+			std::string i = std::to_string(m_next++);
+			m_line = "<http://example.org/s" + i + "> <http://example.org/p> [ <http://example.org/v> " + i + " ] .\n";
+			
+			char *begin = &m_line[0];
+			setg(begin, begin, begin + m_line.size());
+			
+			return traits_type::to_int_type(*gptr());
+		}
+	};
+	
+	/// Counts like the null sink, but starts at a given number.
+	class OffsetSink : public n3::DefaultTripleSink {
+	public:
+		explicit OffsetSink(std::uint64_t offset) : DefaultTripleSink() { m_count = offset; }
+	};
+	
+}
+
+TEST_CASE("triple count passes 2^32", "[counters]")
+{
+	SyntheticStreamBuf buf(1000);
+	std::istream in(&buf);
+	
+	OffsetSink sink(TWO_TO_32 - 500);
+	n3::Parser parser(&in, n3::Uri("http://example.org/"), &sink);
+	parser.parse();
+	
+	REQUIRE(sink.count() == TWO_TO_32 + 1500); // two triples per line
+}
+
+TEST_CASE("scount passes 2^32", "[counters]")
+{
+	SyntheticStreamBuf buf(1);
+	std::istream in(&buf);
+	
+	std::ostringstream out;
+	n3::CN3Writer writer(out);
+	n3::Parser parser(&in, n3::Uri("http://example.org/"), &writer);
+	
+	writer.start();
+	writer.addCount(TWO_TO_32 - 1);
+	parser.parse();
+	writer.end();
+	
+	REQUIRE(writer.count() == TWO_TO_32 + 1);
+	REQUIRE(out.str().find("scount(4294967297).") != std::string::npos);
+}
+
+TEST_CASE("blank node ids stay distinct past 2^32", "[counters]")
+{
+	n3::BlankNodeIdGenerator ids;
+	ids.initialize(42);
+	
+	std::set<std::string> generated;
+	for (int i = 0; i < 4; i++)
+		generated.insert(ids.generate());
+	
+	ids.next(TWO_TO_32 - 2);
+	
+	const std::string prefix = "0000000000000016-"; // 42 in base 36
+	REQUIRE(ids.generate() == prefix + "4294967294");
+	REQUIRE(ids.generate() == prefix + "4294967295");
+	REQUIRE(ids.generate() == prefix + "4294967296");
+	REQUIRE(ids.generate() == prefix + "4294967297");
+	
+	// a 32 bit counter would have wrapped to the first ids
+	ids.next(TWO_TO_32 - 2);
+	for (int i = 0; i < 4; i++)
+		generated.insert(ids.generate());
+	
+	REQUIRE(generated.size() == 8);
+}
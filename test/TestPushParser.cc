@@ -0,0 +1,139 @@
+//
+// Copyright 2017 Giovanni Mels
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "catch.hpp"
+
+#include "../src/Parser.hh"
+#include "../src/PushParser.hh"
+#include "../src/CN3Writer.hh"
+
+namespace {
+	
+	const std::uint64_t SEED = 42;
+	
+	const char *const PREFIXES = "@prefix ex: <http://example.org/> .\n";
+	
+	/// Translates document with Parser, or the error it reports.
+	std::string parse(const std::string &document)
+	{
+		std::istringstream in(document);
+		std::ostringstream out;
+		n3::CN3Writer writer(out);
+		n3::Parser parser(&in, n3::Uri("http://example.org/"), &writer);
+		parser.deterministic(SEED);
+		
+		writer.start();
+		try {
+			parser.parse();
+		} catch (n3::ParseException &e) {
+			return "error";
+		}
+		writer.end();
+		
+		return out.str();
+	}
+	
+	/// Translates document with PushParser, fed one byte at a time, or the error it reports.
+	std::string push(const std::string &document)
+	{
+		std::ostringstream out;
+		n3::CN3Writer writer(out);
+		n3::PushParser parser(n3::Uri("http://example.org/"), &writer);
+		parser.deterministic(SEED);
+		
+		writer.start();
+		try {
+			for (char c : document)
+				parser.feed(&c, 1);
+			parser.finish();
+		} catch (n3::ParseException &e) {
+			return "error";
+		}
+		writer.end();
+		
+		return out.str();
+	}
+	
+}
+
+TEST_CASE("push parser fed byte by byte agrees with the parser", "[push]")
+{
+	const char *const documents[] = {
+		"ex:a ex:b ex:c .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b \"a . string\", 'x . y', \"\"\"long . \"\" string\"\"\" .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b \"escaped \\\" quote . \" .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b [ ex:c ex:d ; ex:e 1.5 ] , ( 1 2.5 3 ) .\nex:e ex:f ex:g . # a comment .\n",
+		"{ ex:a ex:b ex:c . } => { ex:d ex:e ex:f . } .\n",
+		"ex:a ex:b <http://example.org/c.d> .\nex:a ex:b ex:c.d .\n",
+		"ex:a ex:b ex:c\\. , ex:g .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c\\' , ex:d\\# , ex:e\\( , ex:f\\) , ex:g\\~ , ex:h\\, , ex:i\\; .\nex:d ex:e ex:f .\n"
+	};
+	
+	for (const char *document : documents) {
+		std::string input = std::string(PREFIXES) + document;
+		
+		INFO(input);
+		std::string expected = parse(input);
+		REQUIRE(expected != "error");
+		REQUIRE(push(input) == expected);
+	}
+}
+
+TEST_CASE("push parser rejects what the parser rejects", "[push]")
+{
+	const char *const documents[] = {
+		// escapes a local name can not have, a quote does not start a string
+		"ex:a ex:b ex:c\\\" , ex:g .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c\\[ , ex:g .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c\\{ , ex:g .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c ] .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c ) .\nex:d ex:e ex:f .\n",
+		"ex:a ex:b ex:c } .\nex:d ex:e ex:f .\n"
+	};
+	
+	for (const char *document : documents) {
+		std::string input = std::string(PREFIXES) + document;
+		
+		INFO(input);
+		REQUIRE(parse(input) == "error");
+		REQUIRE(push(input) == "error");
+	}
+}
+
+TEST_CASE("push parser recovers the statement end after an unbalanced bracket", "[push]")
+{
+	std::string input = std::string(PREFIXES) + "ex:a ex:b ex:c ] .\nex:d ex:e ex:f .\n";
+	
+	std::ostringstream out;
+	n3::CN3Writer writer(out);
+	n3::PushParser parser(n3::Uri("http://example.org/"), &writer);
+	
+	// the error is reported by the feed() completing the statement, not only at the end
+	bool reported = false;
+	try {
+		for (char c : input)
+			parser.feed(&c, 1);
+	} catch (n3::ParseException &e) {
+		reported = true;
+	}
+	
+	REQUIRE(reported);
+}